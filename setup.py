@@ -66,17 +66,22 @@ class CMakeBuild(build_ext):
         if 'MAX_KMER_SIZE' in env:
             cmake_args.append(f"-DMAX_KMER_SIZE={int(env['MAX_KMER_SIZE']):d}")
 
+        # Additional k-mer widths, each built as separate extension module, e.g. EXTRA_MAX_KMER_SIZES=64,128
+        extra_kmer_sizes = [int(s) for s in re.split(r'[,;]', env.get('EXTRA_MAX_KMER_SIZES', '')) if s.strip()]
+        if extra_kmer_sizes:
+            cmake_args.append(f"-DEXTRA_MAX_KMER_SIZES={';'.join(str(s) for s in extra_kmer_sizes)}")
+
         if not os.path.exists(self.build_temp):
             os.makedirs(self.build_temp)
         subprocess.check_call(['cmake', ext.sourcedir] + cmake_args, cwd=self.build_temp, env=env)
 
         if ext.target:
-            if isinstance(ext.target, list):
-                subprocess.check_call(['cmake', '--build', '.', '--target', *ext.target] + build_args,
-                                      cwd=self.build_temp)
-            else:
-                subprocess.check_call(['cmake', '--build', '.', '--target', ext.target] + build_args,
-                                      cwd=self.build_temp)
+            targets = list(ext.target) if isinstance(ext.target, list) else [ext.target]
+
+            # The modules for additional k-mer widths are part of ALL, so only add them when building specific targets
+            targets += [f'pyfrostcpp_k{kmer_size}' for kmer_size in extra_kmer_sizes]
+            subprocess.check_call(['cmake', '--build', '.', '--target', *targets] + build_args,
+                                  cwd=self.build_temp)
         else:
             subprocess.check_call(['cmake', '--build', '.'] + build_args, cwd=self.build_temp)
 
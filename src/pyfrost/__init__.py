@@ -9,8 +9,9 @@ from pyfrost.seq import *
 from pyfrost.graph import *
 from pyfrost.counter import *
 from pyfrost.minimizers import *
+from pyfrost.sketch import *
 
-from pyfrostcpp import k_g, k, g, set_k_g
+from pyfrost._native import k_g, k, g, set_k_g, module_for_k, available_kmer_widths
 
 from ._version import get_versions
 __version__ = get_versions()['version']
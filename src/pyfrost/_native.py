@@ -0,0 +1,177 @@
+"""
+Selection of the extension module for a k-mer size.
+
+Bifrost's k-mer width is fixed at compile time, so pyfrost can be built with an additional extension module per k-mer
+width (see EXTRA_MAX_KMER_SIZES in CMakeLists.txt), named `pyfrostcpp_k<width>`. All modules register their types
+module local, so they can be loaded side by side. Functions that take a k-mer size, like `set_k_g`, `build`, `load` and
+the `KmerCounter` constructors, dispatch to the narrowest module that supports it, and objects created by a module
+(graphs, counters) keep using that module. The default `pyfrostcpp` module handles k-mer sizes up to 31.
+"""
+
+from __future__ import annotations
+
+import functools
+import importlib
+import pkgutil
+import re
+import struct
+import sys
+
+# MAX_KMER_SIZE of the default module, as set in CMakeLists.txt
+DEFAULT_KMER_WIDTH = 32
+
+# Tag before the count width in saved k-mer counters, see Serialize.h
+COUNT_WIDTH_TAG = 2**64 - 1
+
+# Module used by the last call that selected a k-mer size, its k and g are returned by `k_g()`
+_active_module = None
+
+
+def available_kmer_widths() -> dict[int, str]:
+    """Find the installed additional k-mer width modules, returns a dict mapping k-mer width to module name."""
+
+    widths = {}
+    for module in pkgutil.iter_modules():
+        match = re.fullmatch(r'pyfrostcpp_k(\d+)', module.name)
+        if match:
+            widths[int(match.group(1))] = module.name
+
+    return widths
+
+
+@functools.lru_cache(maxsize=None)
+def _width_modules() -> dict[int, str]:
+    modules = {DEFAULT_KMER_WIDTH: 'pyfrostcpp'}
+    modules.update(available_kmer_widths())
+
+    return modules
+
+
+def module_for_k(k: int):
+    """
+    Import the extension module with the narrowest k-mer width that supports k-mer size `k`, and make it the active
+    module.
+
+    Raises ValueError if none of the installed modules supports `k`.
+    """
+
+    global _active_module
+
+    modules = _width_modules()
+
+    # The last two bits of a k-mer are reserved, so the maximum k-mer size is width - 1
+    fitting = [width for width in modules if int(k) < width]
+    if not fitting:
+        raise ValueError(f"K-mer size is too big! Max k-mer size: {max(modules) - 1}. To use larger k-mers, build "
+                         f"pyfrost with EXTRA_MAX_KMER_SIZES.")
+
+    _active_module = importlib.import_module(modules[min(fitting)])
+
+    return _active_module
+
+
+def module_of(obj):
+    """The extension module that created `obj`, e.g., a graph or k-mer counter."""
+
+    return sys.modules[type(obj).__module__]
+
+
+def active_module():
+    """The extension module selected by the last call that set the k-mer size, or the default module."""
+
+    return _active_module if _active_module is not None else importlib.import_module('pyfrostcpp')
+
+
+def is_native_module(module_name: str) -> bool:
+    return module_name in _width_modules().values()
+
+
+class ActiveModuleDispatch(type):
+    """
+    Metaclass of stand-ins for extension classes that depend on the k-mer size, like `Kmer`.
+
+    Calling the class creates an object of the active module, and `isinstance` matches instances of the class in any of
+    the extension modules. Other attributes are looked up on the class of the active module.
+    """
+
+    def __call__(cls, *args, **kwargs):
+        return cls.native_class(active_module())(*args, **kwargs)
+
+    def __getattr__(cls, name):
+        return getattr(cls.native_class(active_module()), name)
+
+    def __instancecheck__(cls, obj):
+        return type(obj).__name__ == cls.__name__ and is_native_module(type(obj).__module__)
+
+    def native_class(cls, module):
+        return getattr(module, cls.__name__)
+
+
+def active_function(name: str):
+    """Wrap the extension function `name`, such that each call goes to the active module."""
+
+    def call(*args, **kwargs):
+        return getattr(active_module(), name)(*args, **kwargs)
+
+    call.__name__ = call.__qualname__ = name
+    call.__doc__ = getattr(importlib.import_module('pyfrostcpp'), name).__doc__
+
+    return call
+
+
+def peek_counter_k(filepath) -> int:
+    """Read the k-mer size from a file written by one of the k-mer counters' `save` methods."""
+
+    with open(filepath, 'rb') as f:
+        return struct.unpack('=Q', f.read(8))[0]
+
+
+def peek_count_width(filepath) -> int | None:
+    """
+    Read the width of the count slots in bytes from a file written by `KmerCounter.save` or `FrozenKmerCounter.save`.
+    Returns None for files written before the count width was recorded.
+    """
+
+    # k and g as uint64 and canonical as bool, followed by a tag and the uint32 count width. Older files have the number
+    # of tables or k-mers in place of the tag.
+    with open(filepath, 'rb') as f:
+        header = f.read(29)
+
+    if len(header) < 29:
+        return None
+
+    _, _, _, tag, width = struct.unpack('=QQ?QI', header)
+
+    return width if tag == COUNT_WIDTH_TAG else None
+
+
+def peek_header_k(filepath) -> int:
+    """Read the k-mer size from the header of a sorted k-mer counter file or graph snapshot."""
+
+    # Header starts with magic[8], followed by uint32 version and uint32 k
+    with open(filepath, 'rb') as f:
+        return struct.unpack('=8sII', f.read(16))[2]
+
+
+def set_k_g(k: int, g: int = None):
+    """Set the global k-mer and minimizer size, in the module with the narrowest k-mer width that supports `k`."""
+
+    module_for_k(k).set_k_g(k, g)
+
+
+def set_k(k: int):
+    """Set the k-mer size for all `Kmer` objects. Only use at the beginning of the program!"""
+
+    module_for_k(k).set_k(k)
+
+
+def k_g() -> tuple[int, int]:
+    return active_module().k_g()
+
+
+def k() -> int:
+    return active_module().k()
+
+
+def g() -> int:
+    return active_module().g()
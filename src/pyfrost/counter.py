@@ -1,3 +1,104 @@
-from pyfrostcpp import KmerCounter
+"""
+:mod:`pyfrost.counter` - K-mer counters
+=======================================
 
-__all__ = ['KmerCounter']
+Each counter class dispatches to the extension module with the narrowest k-mer width that supports its k-mer size,
+either the given `k` or the k-mer size stored in the file it's loaded from. Loading a file with `KmerCounter` or
+`FrozenKmerCounter` also picks the class with the count width stored in the file, e.g., `KmerCounter8` for a file saved
+by `KmerCounter8`. The classes of a specific count width only load files of that width.
+"""
+
+from __future__ import annotations
+
+import pyfrostcpp
+
+from pyfrost._native import module_for_k, is_native_module, peek_counter_k, peek_count_width, peek_header_k
+
+__all__ = ['KmerCounter', 'KmerCounter8', 'KmerCounter32', 'FrozenKmerCounter', 'FrozenKmerCounter8',
+           'FrozenKmerCounter32', 'MappedKmerCounter', 'ApproxKmerCounter']
+
+
+class KmerWidthDispatch(type):
+    """
+    Metaclass of the counter classes below, which are stand-ins for the extension classes of the same name.
+
+    Calling the class creates an object of the extension module that supports `k`, and `isinstance` matches instances
+    of the class in any of the extension modules. Other attributes are looked up on the class of the default module.
+    """
+
+    def __call__(cls, *args, **kwargs):
+        return cls.create(*args, **kwargs)
+
+    def __getattr__(cls, name):
+        return getattr(cls.native_class(pyfrostcpp), name)
+
+    def __instancecheck__(cls, obj):
+        return type(obj).__name__ == cls.__name__ and is_native_module(type(obj).__module__)
+
+    def native_class(cls, module, count_width: int = None):
+        # Only the generic classes map count widths to classes, see `count_width_classes`
+        name = vars(cls).get('count_width_classes', {}).get(count_width, cls.__name__)
+
+        return getattr(module, name)
+
+    def create(cls, *args, **kwargs):
+        k = kwargs['k'] if 'k' in kwargs else args[0]
+        return cls.native_class(module_for_k(k))(*args, **kwargs)
+
+    def load(cls, filepath, k: int, count_width: int = None):
+        return cls.native_class(module_for_k(k), count_width).from_file(str(filepath))
+
+
+class KmerCounter(metaclass=KmerWidthDispatch):
+    # Class for each count width in bytes, files saved before the count width was recorded have 16-bit counts
+    count_width_classes = {1: 'KmerCounter8', 2: 'KmerCounter', 4: 'KmerCounter32'}
+
+    @classmethod
+    def from_file(cls, filepath):
+        return cls.load(filepath, peek_counter_k(filepath), peek_count_width(filepath))
+
+    @classmethod
+    def merge_files(cls, files, num_threads: int = 2):
+        files = [str(f) for f in files]
+        if not files:
+            return cls.native_class(pyfrostcpp).merge_files(files, num_threads)
+
+        module = module_for_k(peek_counter_k(files[0]))
+
+        return cls.native_class(module, peek_count_width(files[0])).merge_files(files, num_threads)
+
+
+class KmerCounter8(KmerCounter):
+    pass
+
+
+class KmerCounter32(KmerCounter):
+    pass
+
+
+class FrozenKmerCounter(metaclass=KmerWidthDispatch):
+    count_width_classes = {1: 'FrozenKmerCounter8', 2: 'FrozenKmerCounter', 4: 'FrozenKmerCounter32'}
+
+    @classmethod
+    def from_file(cls, filepath):
+        return cls.load(filepath, peek_counter_k(filepath), peek_count_width(filepath))
+
+
+class FrozenKmerCounter8(FrozenKmerCounter):
+    pass
+
+
+class FrozenKmerCounter32(FrozenKmerCounter):
+    pass
+
+
+class ApproxKmerCounter(metaclass=KmerWidthDispatch):
+    @classmethod
+    def from_file(cls, filepath):
+        return cls.load(filepath, peek_counter_k(filepath))
+
+
+class MappedKmerCounter(metaclass=KmerWidthDispatch):
+    @classmethod
+    def create(cls, filepath):
+        return cls.native_class(module_for_k(peek_header_k(filepath)))(str(filepath))
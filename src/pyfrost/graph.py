@@ -10,7 +10,9 @@ from collections import deque, abc
 
 import networkx
 
-from pyfrostcpp import PyfrostCCDBG, NodesDict, NodeDataDict, AdjacencyOuterDict, AdjacencyType, Kmer
+from pyfrostcpp import PyfrostCCDBG, NodesDict, NodeDataDict, AdjacencyOuterDict, AdjacencyType
+from pyfrost._native import module_of
+from pyfrost.seq import Kmer
 from pyfrost.views import PyfrostAdjacencyView, PyfrostNodeView
 
 __all__ = ['BifrostDiGraph', 'Node', 'NodesDict', 'NodeDataDict', 'AdjacencyOuterDict', 'AdjacencyType',
@@ -39,6 +41,10 @@ class BifrostDiGraph(networkx.DiGraph):
     def __init__(self, bifrost_ccdbg=None, **attr):
         self.graph = attr
 
+        # Kmer class of the extension module with the k-mer width of this graph, or of the active module if there's no
+        # Bifrost graph
+        self._kmer_type = Kmer
+
         if bifrost_ccdbg is None:
             # Initialize with empty dicts if no PyfrostCCDBG object given.
             #
@@ -56,9 +62,12 @@ class BifrostDiGraph(networkx.DiGraph):
             self.graph['k'] = bifrost_ccdbg.get_k()
             self.graph['g'] = bifrost_ccdbg.get_g()
 
-            self._node = NodesDict(bifrost_ccdbg)
-            self._adj = AdjacencyOuterDict(bifrost_ccdbg, AdjacencyType.SUCCESSORS)
-            self._pred = AdjacencyOuterDict(bifrost_ccdbg, AdjacencyType.PREDECESSORS)
+            native = module_of(bifrost_ccdbg)
+            self._kmer_type = native.Kmer
+
+            self._node = native.NodesDict(bifrost_ccdbg)
+            self._adj = native.AdjacencyOuterDict(bifrost_ccdbg, native.AdjacencyType.SUCCESSORS)
+            self._pred = native.AdjacencyOuterDict(bifrost_ccdbg, native.AdjacencyType.PREDECESSORS)
             self._succ = self._adj
 
     def add_node(self, node_for_adding, **attr):
@@ -102,7 +111,7 @@ class BifrostDiGraph(networkx.DiGraph):
     def nbunch_iter(self, nbunch=None):
         # Transform any nodes given as str to Kmer objects
         yield from (
-            Kmer(n) if isinstance(n, str) else n for n in super().nbunch_iter(nbunch)
+            self._kmer_type(n) if isinstance(n, str) else n for n in super().nbunch_iter(nbunch)
         )
 
     @property
@@ -137,8 +146,8 @@ class BifrostDiGraph(networkx.DiGraph):
             if not isinstance(allowed_colors, set):
                 allowed_colors = {allowed_colors}
 
-            if not isinstance(node, Kmer):
-                node = Kmer(node)
+            if not isinstance(node, self._kmer_type):
+                node = self._kmer_type(node)
 
             yield from (n.head for n in self._ccdbg.color_restricted_successors(node, allowed_colors))
 
@@ -155,8 +164,8 @@ class BifrostDiGraph(networkx.DiGraph):
             if not isinstance(allowed_colors, set):
                 allowed_colors = {allowed_colors}
 
-            if not isinstance(node, Kmer):
-                node = Kmer(node)
+            if not isinstance(node, self._kmer_type):
+                node = self._kmer_type(node)
 
             yield from (n.head for n in self._ccdbg.color_restricted_predecessors(node, allowed_colors))
 
@@ -179,7 +188,7 @@ def get_neighborhood(g: BifrostDiGraph, source, radius=3, both_directions=True,
     excl_nodes = excl_nodes if excl_nodes is not None else set()
 
     queue = deque()
-    if isinstance(source, Kmer) or isinstance(source, str):
+    if isinstance(source, g._kmer_type) or isinstance(source, str):
         queue.append((0, source))
     else:
         for src_node in source:
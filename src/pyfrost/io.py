@@ -12,18 +12,20 @@ from itertools import zip_longest
 from typing import Union, TextIO, BinaryIO, Iterable, Optional, NamedTuple
 
 import pyfrostcpp
+from pyfrostcpp import GraphSnapshot
 
+from pyfrost._native import module_for_k, module_of, peek_header_k
 from pyfrost.graph import BifrostDiGraph
 
-__all__ = ['build', 'build_from_refs', 'build_from_samples', 'load', 'dump', 'open_compressed',
-           'read_fastq', 'read_paired_fastq']
+__all__ = ['build', 'build_from_refs', 'build_from_samples', 'build_from_counter', 'add_samples', 'load', 'dump',
+           'dump_snapshot', 'load_snapshot', 'GraphSnapshot', 'open_compressed', 'read_fastq', 'read_paired_fastq']
 
 
 def load(graph: Union[str, Path], **kwargs):
     """
     Load a Bifrost graph from a file.
 
-    Automatically determines the bfg_colors path from the given GFA file.
+    Automatically determines the bfg_colors path from the given GFA file, and the k-mer size from its header.
 
     Parameters
     ----------
@@ -48,7 +50,33 @@ def load(graph: Union[str, Path], **kwargs):
     if not colors_file.is_file():
         raise IOError(f"Could not find graph colors file {colors_file}")
 
-    return BifrostDiGraph(pyfrostcpp.load(str(graph), str(colors_file), **kwargs))
+    k = gfa_kmer_size(graph)
+    if k is None:
+        k = kwargs.get('k', pyfrostcpp.default_k)
+
+    return BifrostDiGraph(module_for_k(k).load(str(graph), str(colors_file), **kwargs))
+
+
+def gfa_kmer_size(graph: Path, max_lines: int=10000) -> Optional[int]:
+    """
+    Determine the k-mer size of a GFA file written by Bifrost, from the `KL` header tag or else from the overlap of the
+    first link (k - 1). Returns None if neither is found in the first `max_lines` lines.
+    """
+
+    with open_compressed(graph, "rt") as f:
+        for i, line in enumerate(f):
+            if i >= max_lines:
+                break
+
+            fields = line.rstrip('\n').split('\t')
+            if fields[0] == 'H':
+                for tag in fields[1:]:
+                    if tag.startswith('KL:'):
+                        return int(tag.split(':')[-1])
+            elif fields[0] == 'L' and len(fields) > 5 and fields[5].endswith('M'):
+                return int(fields[5][:-1]) + 1
+
+    return None
 
 
 def build(refs: list[str], samples: list[str], **kwargs):
@@ -65,7 +93,7 @@ def build(refs: list[str], samples: list[str], **kwargs):
     -------
 
     """
-    return BifrostDiGraph(pyfrostcpp.build(refs, samples, **kwargs))
+    return BifrostDiGraph(module_for_k(kwargs.get('k', pyfrostcpp.default_k)).build(refs, samples, **kwargs))
 
 
 def build_from_refs(refs: list[str], **kwargs):
@@ -76,8 +104,85 @@ def build_from_samples(samples: list[str], **kwargs):
     return build([], samples, **kwargs)
 
 
+def build_from_counter(counter, min_count: int=2, **kwargs):
+    """
+    Build a Bifrost graph from the k-mers in a `KmerCounter`, without reading the sequencing data again.
+
+    Only k-mers with a count of at least `min_count` are included in the graph, which gets a single color.
+
+    Parameters
+    ----------
+    counter : KmerCounter
+        K-mer counter, its k-mer size is used for the graph
+    min_count : int
+        Minimum count of a k-mer to be included in the graph
+    kwargs
+        Additional build options, e.g. `g`, `threads`, `clip_tips`. `color_name` sets the name of the color, and
+        `tmp_dir` the directory for the temporary k-mer file.
+
+    Returns
+    -------
+    BifrostDiGraph
+    """
+    g = BifrostDiGraph(module_of(counter).build_from_counter(counter, min_count, **kwargs))
+
+    # Bifrost names the color after the temporary k-mer file
+    g.graph['color_names'] = [kwargs.get('color_name', 'counter')]
+
+    return g
+
+
+def add_samples(g: BifrostDiGraph, refs: list[str], samples: Optional[list[str]] = None, **kwargs):
+    """
+    Add new references and/or samples to an existing graph, without rebuilding the graph from all files.
+
+    Only the k-mers of the new files are inserted, and only the unitigs they touch are split or joined, so the time
+    taken depends on the size of the new data. Each file gets a new color.
+
+    Parameters
+    ----------
+    g : BifrostDiGraph
+        Graph to add the samples to, modified in place
+    refs : list[str]
+        Reference FASTA/FASTQ files, all k-mers are added
+    samples : list[str]
+        Sequencing data FASTA/FASTQ files, k-mers are filtered on abundance as in `build`
+    kwargs
+        Additional build options, e.g. `threads`, `clip_tips` or `verbose`. These only apply to the new samples.
+    """
+
+    module_of(g._ccdbg).add_samples(g._ccdbg, list(refs), list(samples) if samples else [], **kwargs)
+
+    # New colors are appended, keep the names of the existing colors in case they were renamed
+    color_names = list(g._ccdbg.color_names())
+    g.graph['color_names'] = g.graph['color_names'] + color_names[len(g.graph['color_names']):]
+
+
 def dump(g: BifrostDiGraph, fname_prefix: str, num_threads: int=2):
-    return pyfrostcpp.dump(g._ccdbg, fname_prefix, num_threads)
+    return module_of(g._ccdbg).dump(g._ccdbg, fname_prefix, num_threads)
+
+
+def dump_snapshot(g: BifrostDiGraph, filepath: Union[str, Path], num_threads: int=2, tmp_dir: str=""):
+    """
+    Save the graph as binary snapshot, which can be opened with `load_snapshot` in constant time.
+
+    The snapshot contains the unitig sequences, an index of all k-mers and the colors of each k-mer. Use it for
+    read-only queries from (many) worker processes; it can't be modified or converted back to a `BifrostDiGraph`.
+    While writing, the k-mers are sorted in buckets spilled to `tmp_dir` (defaults to $TMPDIR or /tmp).
+    """
+
+    module_of(g._ccdbg).dump_snapshot(g._ccdbg, str(filepath), num_threads, str(tmp_dir))
+
+
+def load_snapshot(filepath: Union[str, Path]) -> GraphSnapshot:
+    """
+    Open a graph snapshot saved with `dump_snapshot`.
+
+    The file is memory mapped, so this doesn't read the graph into memory, and processes opening the same snapshot
+    share its memory. The k-mer size of the snapshot has to equal the current k-mer size, see `set_k_g`.
+    """
+
+    return module_for_k(peek_header_k(filepath)).GraphSnapshot(str(filepath))
 
 
 def open_compressed(filename, *args, **kwargs) -> Union[TextIO, BinaryIO]:
@@ -3,16 +3,45 @@ Tools to obtain minimizers from a sequence
 """
 
 from __future__ import annotations
-from typing import Optional, NamedTuple, Iterable
+from typing import Optional, NamedTuple, Iterable, Sequence
 
-from pyfrostcpp import Strand, Minimizer, minhash_iter, k_g
+import numpy
 
-__all__ = ['MinimizerResult', 'Minimizer', 'all_minimizers']
+from pyfrostcpp import Strand
+from pyfrost._native import k_g, ActiveModuleDispatch, active_function
+
+__all__ = ['MinimizerResult', 'Minimizer', 'all_minimizers', 'MinimizerArrays', 'minimizers_array',
+           'minimizers_batch']
+
+
+class Minimizer(metaclass=ActiveModuleDispatch):
+    """A minimizer, created by the extension module of the current k-mer size."""
+
+
+minhash_iter = active_function('minhash_iter')
+_minimizers_array = active_function('minimizers_array')
+_minimizers_batch = active_function('minimizers_batch')
+
+
+class MinimizerArrays(NamedTuple):
+    """
+    Minimizers of one or more sequences as numpy arrays, with one entry per super-k-mer: a maximal run of consecutive
+    k-mers with the same minimizer.
+    """
+
+    hashes: numpy.ndarray
+    positions: numpy.ndarray
+    strands: numpy.ndarray
+    starts: numpy.ndarray
+    ends: numpy.ndarray
+    seq_indices: Optional[numpy.ndarray] = None
 
 
 class MinimizerResult(NamedTuple):
-    """A single identified minimizer in a given sequence, with additional information
-    like the current k-mer position, and the minimizer position in the sequence."""
+    """
+    A single identified minimizer in a given sequence, with additional information like the current k-mer position, and
+    the minimizer position in the sequence.
+    """
 
     minimizer: Minimizer
     kmer_pos: int
@@ -24,13 +53,11 @@ def all_minimizers(sequence: str, k: Optional[int] = None, g: Optional[int] = No
     """
     Yield all unique minimizers in a sequence.
 
-    Always yields the lexigraphically smallest minimizer, i.e., it could be located on
-    the forward or reverse strand.
+    Always yields the lexigraphically smallest minimizer, i.e., it could be located on the forward or reverse strand.
     """
 
-    # Because minhash_iter is a C++ function, just passing None values for k or g
-    # will result in a type error (the type is size_t). So that's why we do more
-    # convoluted overloading.
+    # Because minhash_iter is a C++ function, just passing None values for k or g will result in a type error (the type
+    # is size_t). So that's why we do more convoluted overloading.
     curr_k, curr_g = k_g()
     if k is None and g is None:
         mh_iter = iter(minhash_iter(sequence))
@@ -56,3 +83,28 @@ def all_minimizers(sequence: str, k: Optional[int] = None, g: Optional[int] = No
             yield MinimizerResult(minimizer_rep, kmer_pos, result.pos, strand)
 
             last_pos = result.pos
+
+
+def minimizers_array(sequence: str, k: Optional[int] = None, g: Optional[int] = None) -> MinimizerArrays:
+    """
+    Find the minimizer of each super-k-mer in a sequence.
+
+    Returns the minimizer hash, the start position and strand of the minimizer (as `Strand` value), and the start and
+    (exclusive) end position of each super-k-mer. Super-k-mers also end at non-ACGT characters.
+
+    Minimizers are the same as the ones yielded by `all_minimizers` and used by the graph: the g-mer with the smallest
+    `RepHash` in a k-mer, where the hash doesn't depend on the strand. If several g-mers in a k-mer have the smallest
+    hash, the leftmost one is the minimizer.
+    """
+
+    return MinimizerArrays(*_minimizers_array(sequence, k, g))
+
+
+def minimizers_batch(sequences: Sequence[str], k: Optional[int] = None, g: Optional[int] = None,
+                     threads: int = 2) -> MinimizerArrays:
+    """
+    Find the minimizers of many sequences at once with multiple threads, see `minimizers_array`. The `seq_indices`
+    array gives the sequence index of each super-k-mer.
+    """
+
+    return MinimizerArrays(*_minimizers_batch(list(sequences), k, g, threads))
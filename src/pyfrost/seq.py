@@ -6,13 +6,26 @@
 from __future__ import annotations
 from typing import TYPE_CHECKING, Iterable, Sequence
 
-from pyfrostcpp import reverse_complement, Kmer, kmerize_str, Strand, set_k, max_k, max_g
+from pyfrostcpp import reverse_complement, Strand, max_k, max_g
+from pyfrost._native import set_k, ActiveModuleDispatch, active_function
 
 if TYPE_CHECKING:
     from pyfrost.graph import BifrostDiGraph
 
-__all__ = ['reverse_complement', 'Kmer', 'kmerize_str', 'Strand', 'set_k', 'max_k', 'max_g', 'path_sequence',
-           'path_nucleotide_length', 'path_kmers', 'path_rev_compl']
+__all__ = ['reverse_complement', 'Kmer', 'KmerArray', 'kmerize_str', 'kmerize_batch', 'Strand', 'set_k', 'max_k',
+           'max_g', 'path_sequence', 'path_nucleotide_length', 'path_kmers', 'path_rev_compl']
+
+
+class Kmer(metaclass=ActiveModuleDispatch):
+    """A k-mer, created by the extension module of the current k-mer size."""
+
+
+class KmerArray(metaclass=ActiveModuleDispatch):
+    """A packed array of k-mers, created by the extension module of the current k-mer size."""
+
+
+kmerize_str = active_function('kmerize_str')
+kmerize_batch = active_function('kmerize_batch')
 
 
 def path_sequence(g: BifrostDiGraph, path: Iterable[Kmer]) -> str:
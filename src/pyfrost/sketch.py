@@ -0,0 +1,59 @@
+"""
+:mod:`pyfrost.sketch` - FracMinHash sketches of files and graph colors
+======================================================================
+
+A FracMinHash sketch keeps the hashes of roughly one in `scale` distinct canonical k-mers, which is enough to estimate
+the Jaccard index and containment between (large) k-mer sets.
+"""
+
+from __future__ import annotations
+from typing import TYPE_CHECKING, Optional, Sequence
+
+import numpy
+
+from pyfrostcpp import FracMinHash, save_sketches, load_sketches
+from pyfrost._native import active_module, module_of
+
+if TYPE_CHECKING:
+    from pyfrost.graph import BifrostDiGraph
+
+__all__ = ['FracMinHash', 'sketch_files', 'sketch_colors', 'jaccard_matrix', 'containment_matrix', 'save_sketches',
+           'load_sketches']
+
+
+def sketch_files(files: Sequence[str], scale: int = 1000, seed: int = 42, threads: int = 2) -> list[FracMinHash]:
+    """Build a sketch of each FASTA/FASTQ file, with files divided over `threads` threads."""
+
+    return active_module().sketch_files(list(files), scale, seed, threads)
+
+
+def sketch_colors(g: BifrostDiGraph, scale: int = 1000, seed: int = 42, threads: int = 2) -> list[FracMinHash]:
+    """Build a sketch of the k-mers of each color in the graph, named by color name."""
+
+    return module_of(g._ccdbg).sketch_colors(g._ccdbg, scale, seed, threads)
+
+
+def jaccard_matrix(sketches: Sequence[FracMinHash], others: Optional[Sequence[FracMinHash]] = None,
+                   threads: int = 2) -> numpy.ndarray:
+    """
+    Estimated Jaccard index of each sketch in `sketches` (rows) with each sketch in `others` (columns). Compares
+    `sketches` all-vs-all if `others` is not given.
+    """
+
+    sketches = list(sketches)
+    native = module_of(sketches[0]) if sketches else active_module()
+
+    return native.jaccard_matrix(sketches, list(others) if others is not None else None, threads)
+
+
+def containment_matrix(sketches: Sequence[FracMinHash], others: Optional[Sequence[FracMinHash]] = None,
+                       threads: int = 2) -> numpy.ndarray:
+    """
+    Estimated fraction of the k-mers of each sketch in `sketches` (rows) that is contained in each sketch in `others`
+    (columns). Compares `sketches` all-vs-all if `others` is not given.
+    """
+
+    sketches = list(sketches)
+    native = module_of(sketches[0]) if sketches else active_module()
+
+    return native.containment_matrix(sketches, list(others) if others is not None else None, threads)
@@ -75,11 +75,11 @@ py::dict AdjacencyInnerDict::getEdgeDict(Kmer const& neighbor) const {
 }
 
 void define_AdjacencyInnerDict(py::module& m) {
-    py::enum_<AdjacencyType>(m, "AdjacencyType")
+    py::enum_<AdjacencyType>(m, "AdjacencyType", py::module_local())
         .value("SUCCESSORS", AdjacencyType::SUCCESSORS)
         .value("PREDECESSORS", AdjacencyType::PREDECESSORS);
 
-    auto py_AdjacencyInnerDict = py::class_<AdjacencyInnerDict>(m, "AdjacencyInnerDict")
+    auto py_AdjacencyInnerDict = py::class_<AdjacencyInnerDict>(m, "AdjacencyInnerDict", py::module_local())
         .def("__iter__", [] (AdjacencyInnerDict const& self) {
             return py::make_iterator<py::return_value_policy::copy>(self.begin(), self.end());
         }, py::keep_alive<0, 1>())
@@ -4,7 +4,7 @@ namespace pyfrost {
 
 void define_AdjacencyOuterDict(py::module& m) {
 
-    auto py_AdjacencyOuterDict = py::class_<AdjacencyOuterDict>(m, "AdjacencyOuterDict")
+    auto py_AdjacencyOuterDict = py::class_<AdjacencyOuterDict>(m, "AdjacencyOuterDict", py::module_local())
         .def(py::init<PyfrostCCDBG&, AdjacencyType>())
 
         .def("__len__", &AdjacencyOuterDict::numNodes, py::is_operator())
@@ -0,0 +1,305 @@
+#include "ApproxKmerCounter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <cereal/archives/binary.hpp>
+
+using std::vector;
+using std::string;
+
+namespace pyfrost {
+
+ApproxKmerCounter::ApproxKmerCounter(size_t _k, size_t _g, bool _canonical, size_t _num_threads, size_t _width_bits,
+    size_t _depth, size_t _partition_bits, size_t _batch_size, size_t _num_readers) :
+    k(_k), g(_g), canonical(_canonical), num_threads(_num_threads), batch_size(_batch_size),
+    num_readers(std::max(size_t(1), _num_readers)),
+    sketches(size_t(1) << std::min(_partition_bits, _width_bits),
+             CountMinSketch(_width_bits - std::min(_partition_bits, _width_bits), _depth)),
+    num_kmers(0), max_count(0), pipeline(num_threads, batch_size, num_readers)
+{
+    setKG(k, g);
+}
+
+ApproxKmerCounter::ApproxKmerCounter(ApproxKmerCounter const& o) :
+    k(o.k), g(o.g), canonical(o.canonical), num_threads(o.num_threads), batch_size(o.batch_size),
+    num_readers(o.num_readers), sketches(o.sketches), num_kmers(o.num_kmers.load()), max_count(o.max_count.load()),
+    pipeline(num_threads, batch_size, num_readers)
+{
+    setKG(k, g);
+}
+
+ApproxKmerCounter::ApproxKmerCounter(ApproxKmerCounter&& o) :
+    k(o.k), g(o.g), canonical(o.canonical), num_threads(o.num_threads), batch_size(o.batch_size),
+    num_readers(o.num_readers), sketches(std::move(o.sketches)), num_kmers(o.num_kmers.load()),
+    max_count(o.max_count.load()), pipeline(num_threads, batch_size, num_readers)
+{
+    setKG(k, g);
+}
+
+ApproxKmerCounter::~ApproxKmerCounter()
+{
+    if(isStreaming()) {
+        finish();
+    }
+}
+
+ApproxKmerCounter& ApproxKmerCounter::countKmersFiles(std::vector<std::string> const& files)
+{
+    pipeline.run(files, [this] () { counterThread(); });
+    return *this;
+}
+
+ApproxKmerCounter& ApproxKmerCounter::countKmers(std::string const& str)
+{
+    if(isStreaming()) {
+        feed(vector<string> {str});
+        return *this;
+    }
+
+    uint64_t thread_kmers = 0;
+    count_type thread_max = 0;
+    countRead(str, thread_kmers, thread_max);
+    mergeThreadStats(thread_kmers, thread_max);
+
+    return *this;
+}
+
+void ApproxKmerCounter::start()
+{
+    pipeline.start([this] () { counterThread(); });
+}
+
+void ApproxKmerCounter::feed(std::vector<std::string>&& batch)
+{
+    pipeline.feed(std::move(batch));
+}
+
+ApproxKmerCounter& ApproxKmerCounter::finish()
+{
+    pipeline.finish();
+    return *this;
+}
+
+void ApproxKmerCounter::counterThread()
+{
+    uint64_t thread_kmers = 0;
+    count_type thread_max = 0;
+
+    pipeline.processQueue([&] (string const& sequence) {
+        countRead(sequence, thread_kmers, thread_max);
+    });
+
+    mergeThreadStats(thread_kmers, thread_max);
+}
+
+void ApproxKmerCounter::countRead(std::string const& sequence, uint64_t& thread_kmers, count_type& thread_max)
+{
+    forEachSuperKmer(sequence, sketches.size(), canonical, [&] (size_t partition, KmerRun const& run, int) {
+        thread_kmers += run.size();
+        thread_max = std::max(thread_max, sketches[partition].incrementBatch(run.begin(), run.end()));
+    });
+}
+
+void ApproxKmerCounter::mergeThreadStats(uint64_t thread_kmers, count_type thread_max)
+{
+    num_kmers += thread_kmers;
+
+    count_type curr_max = max_count.load();
+    while(thread_max > curr_max && !max_count.compare_exchange_weak(curr_max, thread_max)) { }
+}
+
+ApproxKmerCounter::count_type ApproxKmerCounter::query(Kmer const& qry) const
+{
+    Kmer kmer = canonical ? qry.rep() : qry;
+
+    return sketches[minimizerPartition(kmer, sketches.size())].query(kmer);
+}
+
+ApproxKmerCounter::count_type ApproxKmerCounter::query(char const* qry) const
+{
+    return query(Kmer(qry));
+}
+
+std::vector<ApproxKmerCounter::count_type> ApproxKmerCounter::queryMany(std::vector<Kmer> const& kmers) const
+{
+    vector<count_type> counts;
+    counts.reserve(kmers.size());
+
+    for(auto const& kmer : kmers) {
+        counts.push_back(query(kmer));
+    }
+
+    return counts;
+}
+
+std::vector<ApproxKmerCounter::count_type> ApproxKmerCounter::queryMany(uint64_t const* words, size_t num_kmers) const
+{
+    vector<count_type> counts;
+    counts.reserve(num_kmers);
+
+    for(size_t i = 0; i < num_kmers; ++i) {
+        counts.push_back(query(kmer_from_words(words + i * KMER_WORDS)));
+    }
+
+    return counts;
+}
+
+std::vector<ApproxKmerCounter::count_type> ApproxKmerCounter::querySequence(std::string const& sequence) const
+{
+    if(sequence.size() < Kmer::k) {
+        return {};
+    }
+
+    // Walk the sequence by super-k-mer, so the partition of each k-mer comes from the rolling minimizer
+    vector<count_type> counts(sequence.size() - Kmer::k + 1, 0);
+    forEachSuperKmer(sequence, sketches.size(), canonical, [&] (size_t partition, KmerRun const& run,
+                                                                int run_start) {
+        for(size_t i = 0; i < run.size(); ++i) {
+            counts[run_start + i] = sketches[partition].query(run[i]);
+        }
+    });
+
+    return counts;
+}
+
+double ApproxKmerCounter::getEpsilon() const
+{
+    return std::exp(1.0) / sketches.front().getWidth();
+}
+
+double ApproxKmerCounter::getDelta() const
+{
+    return std::exp(-static_cast<double>(sketches.front().getDepth()));
+}
+
+uint64_t ApproxKmerCounter::errorBound(Kmer const& qry) const
+{
+    Kmer kmer = canonical ? qry.rep() : qry;
+    uint64_t partition_total = sketches[minimizerPartition(kmer, sketches.size())].getTotal();
+
+    return static_cast<uint64_t>(std::ceil(getEpsilon() * partition_total));
+}
+
+uint64_t ApproxKmerCounter::maxErrorBound() const
+{
+    uint64_t max_total = 0;
+    for(auto const& sketch : sketches) {
+        max_total = std::max(max_total, sketch.getTotal());
+    }
+
+    return static_cast<uint64_t>(std::ceil(getEpsilon() * max_total));
+}
+
+size_t ApproxKmerCounter::getMemoryUsage() const
+{
+    return sketches.size() * sketches.front().getWidth() * sketches.front().getDepth() * sizeof(count_type);
+}
+
+void define_ApproxKmerCounter(py::module& m) {
+    py::class_<ApproxKmerCounter>(m, "ApproxKmerCounter", py::module_local(),
+                                  "Approximate k-mer counter with a fixed memory budget, backed by count-min sketches "
+                                  "with conservative update. Estimated counts are never lower than the true count.")
+        .def(py::init<size_t, size_t, bool, size_t, size_t, size_t, size_t, size_t, size_t>(),
+            py::arg("k"), py::arg("g") = 0, py::arg("canonical") = true, py::arg("num_threads") = 2,
+            py::arg("width_bits") = 24, py::arg("depth") = 4, py::arg("partition_bits") = 10,
+            py::arg("batch_size") = 100000, py::arg("num_readers") = 1)
+        .def("count_kmers", &ApproxKmerCounter::countKmers, py::call_guard<py::gil_scoped_release>())
+        .def("count_kmers_files", &ApproxKmerCounter::countKmersFiles, py::call_guard<py::gil_scoped_release>())
+
+        .def("start", &ApproxKmerCounter::start,
+            "Start a streaming session, with a pool of counter threads that count sequences passed to `feed`.")
+        .def("feed", [] (ApproxKmerCounter& self, vector<string> batch) {
+            py::gil_scoped_release release;
+            self.feed(std::move(batch));
+        }, py::arg("batch"),
+            "Queue a list of sequences (str or bytes) for counting. Blocks while the queue of pending batches is full.")
+        .def("finish", &ApproxKmerCounter::finish, py::return_value_policy::reference_internal,
+            py::call_guard<py::gil_scoped_release>(),
+            "Wait until all fed sequences are counted, and end the streaming session.")
+        .def_property_readonly("is_streaming", &ApproxKmerCounter::isStreaming)
+
+        .def("query", py::overload_cast<Kmer const&>(&ApproxKmerCounter::query, py::const_))
+        .def("query", py::overload_cast<char const*>(&ApproxKmerCounter::query, py::const_))
+        .def("__getitem__", py::overload_cast<Kmer const&>(&ApproxKmerCounter::query, py::const_))
+        .def("__getitem__", py::overload_cast<char const*>(&ApproxKmerCounter::query, py::const_))
+
+        .def("query_many", [] (ApproxKmerCounter const& self, string const& sequence) {
+            vector<ApproxKmerCounter::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.querySequence(sequence);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("sequence"), "Query all k-mers in a sequence, returns a numpy array with an estimate per position.")
+
+        .def("query_many", [] (ApproxKmerCounter const& self,
+                               py::array_t<uint64_t, py::array::c_style | py::array::forcecast> const& kmers) {
+            if(kmers.ndim() != 2 || static_cast<size_t>(kmers.shape(1)) != KMER_WORDS) {
+                throw py::value_error("Expected an array of packed k-mers with shape (n, "
+                                      + std::to_string(KMER_WORDS) + ").");
+            }
+
+            uint64_t const* words = kmers.data();
+            auto num_kmers = static_cast<size_t>(kmers.shape(0));
+
+            vector<ApproxKmerCounter::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.queryMany(words, num_kmers);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("kmers"), "Query an array of packed k-mers, returns a numpy array with the estimate of each k-mer.")
+
+        .def("query_many", [] (ApproxKmerCounter const& self, vector<Kmer> const& kmers) {
+            vector<ApproxKmerCounter::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.queryMany(kmers);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("kmers"), "Query a list of k-mers, returns a numpy array with the estimate of each k-mer.")
+
+        .def("error_bound", [] (ApproxKmerCounter const& self, Kmer const& kmer) {
+            return self.errorBound(kmer);
+        }, py::arg("kmer"), "Additive error bound of the estimate of a k-mer, which holds with probability "
+                            "`1 - delta`.")
+        .def("error_bound", [] (ApproxKmerCounter const& self, char const* kmer) {
+            return self.errorBound(Kmer(kmer));
+        }, py::arg("kmer"))
+
+        .def_property_readonly("epsilon", &ApproxKmerCounter::getEpsilon,
+            "Estimates exceed the true count by at most epsilon times the number of k-mers in their partition.")
+        .def_property_readonly("delta", &ApproxKmerCounter::getDelta,
+            "Probability that an estimate exceeds its error bound.")
+        .def_property_readonly("max_error", &ApproxKmerCounter::maxErrorBound,
+            "Largest error bound over all partitions.")
+        .def_property_readonly("k", &ApproxKmerCounter::getK)
+        .def_property_readonly("num_kmers", &ApproxKmerCounter::getNumKmers)
+        .def_property_readonly("max_count", &ApproxKmerCounter::getMaxCount)
+        .def_property_readonly("memory_usage", &ApproxKmerCounter::getMemoryUsage,
+            "Size of the sketches in bytes.")
+
+        .def("save", [] (ApproxKmerCounter& self, string const& filepath) {
+            std::ofstream ofile(filepath);
+            cereal::BinaryOutputArchive archive(ofile);
+
+            archive(cereal::make_nvp("approxkmercounter", self));
+        })
+
+        .def_static("from_file", [] (string const& filepath) {
+            ApproxKmerCounter kmer_counter;
+
+            std::ifstream ifile(filepath);
+            cereal::BinaryInputArchive archive(ifile);
+
+            archive(kmer_counter);
+
+            return kmer_counter;
+        });
+}
+
+}
@@ -0,0 +1,152 @@
+/**
+ * Approximate k-mer counter with a fixed memory budget.
+ *
+ * Counts are kept in count-min sketches with conservative update, one per minimizer partition. Reads are processed
+ * with the same pipeline as `KmerCounter`: reads are cut into super-k-mers, and each super-k-mer is added to the
+ * sketch of its partition while holding that sketch's lock only once. Because each partition has its own sketch, the
+ * error of an estimate depends only on the number of k-mers in its partition.
+ *
+ * Estimates are never lower than the true count. Memory use is fixed at `4 * depth * 2^width_bits` bytes, regardless
+ * of the number of distinct k-mers in the input.
+ */
+
+#ifndef PYFROST_APPROXKMERCOUNTER_H
+#define PYFROST_APPROXKMERCOUNTER_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+#include "CountMinSketch.h"
+#include "SequencePipeline.h"
+#include "Serialize.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace pyfrost {
+
+class ApproxKmerCounter {
+public:
+    using count_type = CountMinSketch::count_type;
+
+    /**
+     * @param num_threads Number of counting threads
+     * @param width_bits Log2 of the total number of counters per sketch row, divided over all partitions
+     * @param depth Number of rows (hash functions) per sketch, at most 16. The probability that an estimate exceeds
+     *              its error bound is `exp(-depth)`.
+     * @param partition_bits Log2 of the number of minimizer partitions, each with their own sketch
+     * @param num_readers Number of threads reading input files
+     */
+    ApproxKmerCounter(size_t k=DEFAULT_K, size_t g=0, bool canonical=true, size_t num_threads=2, size_t width_bits=24,
+        size_t depth=4, size_t partition_bits=10, size_t batch_size=100000, size_t num_readers=1);
+
+    ApproxKmerCounter(ApproxKmerCounter const& o);
+    ApproxKmerCounter(ApproxKmerCounter&& o);
+    ~ApproxKmerCounter();
+
+    ApproxKmerCounter& countKmersFiles(std::vector<std::string> const& files);
+    ApproxKmerCounter& countKmers(std::string const& str);
+
+    /**
+     * Start a streaming session, see `KmerCounter::start`.
+     */
+    void start();
+    void feed(std::vector<std::string>&& batch);
+    ApproxKmerCounter& finish();
+
+    bool isStreaming() const {
+        return pipeline.isStreaming();
+    }
+
+    count_type query(Kmer const& qry) const;
+    count_type query(char const* qry) const;
+
+    std::vector<count_type> queryMany(std::vector<Kmer> const& kmers) const;
+    std::vector<count_type> queryMany(uint64_t const* words, size_t num_kmers) const;
+
+    /**
+     * Query all k-mers in a sequence. Returns an estimate for each k-mer position, k-mers with non-ACGT characters get
+     * count 0.
+     */
+    std::vector<count_type> querySequence(std::string const& sequence) const;
+
+    /**
+     * Relative error of the sketches: an estimate exceeds the true count by at most `epsilon` times the number of
+     * k-mers in its partition, with probability `1 - delta`.
+     */
+    double getEpsilon() const;
+    double getDelta() const;
+
+    /**
+     * Additive error bound of the estimate of a k-mer, which holds with probability `1 - delta`.
+     */
+    uint64_t errorBound(Kmer const& qry) const;
+
+    /**
+     * Largest error bound over all partitions.
+     */
+    uint64_t maxErrorBound() const;
+
+    size_t getK() const {
+        return k;
+    }
+
+    size_t getG() const {
+        return g;
+    }
+
+    uint64_t getNumKmers() const {
+        return num_kmers.load();
+    }
+
+    /**
+     * Highest estimated count seen while counting.
+     */
+    count_type getMaxCount() const {
+        return max_count.load();
+    }
+
+    size_t getMemoryUsage() const;
+
+    template<typename Archive>
+    void save(Archive& ar) const {
+        ar(k, g, canonical, sketches, num_kmers.load(), max_count.load());
+    }
+
+    template<typename Archive>
+    void load(Archive& ar) {
+        ar(k, g, canonical);
+        setKG(k, g);
+
+        uint64_t _num_kmers = 0;
+        count_type _max_count = 0;
+        ar(sketches, _num_kmers, _max_count);
+
+        num_kmers = _num_kmers;
+        max_count = _max_count;
+    }
+
+private:
+    void counterThread();
+    void countRead(std::string const& sequence, uint64_t& thread_kmers, count_type& thread_max);
+    void mergeThreadStats(uint64_t thread_kmers, count_type thread_max);
+
+    size_t k;
+    size_t g;
+    bool canonical;
+    size_t num_threads;
+    size_t batch_size;
+    size_t num_readers;
+
+    std::vector<CountMinSketch> sketches;
+    std::atomic<uint64_t> num_kmers;
+    std::atomic<count_type> max_count;
+
+    SequencePipeline pipeline;
+};
+
+void define_ApproxKmerCounter(py::module& m);
+
+}
+
+#endif //PYFROST_APPROXKMERCOUNTER_H
@@ -0,0 +1,205 @@
+/**
+ * A count-min sketch of k-mers with conservative update.
+ *
+ * The sketch has `depth` rows of `width` counters. A k-mer maps to one counter per row, and its estimated count is
+ * the minimum of those counters. Estimates are never too low, and exceed the true count by at most `e / width` times
+ * the total number of insertions with probability `1 - exp(-depth)`.
+ *
+ * With conservative update, an insertion only raises the counters that are below the new estimate, instead of
+ * incrementing all of them. This keeps the same guarantee, but considerably reduces the overestimation in practice.
+ * Conservative update needs the read and the write to happen atomically, so each sketch has a mutex. Counters should
+ * use many sketches, e.g., one per minimizer partition, to avoid contention.
+ *
+ * Cormode, Graham, and Shan Muthukrishnan. "An improved data stream summary: the count-min sketch and its
+ * applications." Journal of Algorithms 55.1 (2005).
+ *
+ * Estan, Cristian, and George Varghese. "New directions in traffic measurement and accounting." SIGCOMM 2002.
+ */
+
+#ifndef PYFROST_COUNTMINSKETCH_H
+#define PYFROST_COUNTMINSKETCH_H
+
+#include "Kmer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace pyfrost {
+
+class CountMinSketch {
+public:
+    using count_type = uint32_t;
+
+    static constexpr count_type MAX_COUNT = std::numeric_limits<count_type>::max();
+    static constexpr size_t MAX_DEPTH = 16;
+
+    /**
+     * @param width_bits Log2 of the number of counters per row
+     * @param depth Number of rows, at most `MAX_DEPTH`
+     */
+    explicit CountMinSketch(size_t _width_bits = 0, size_t _depth = 1) :
+        width(size_t(1) << _width_bits), depth(std::max(size_t(1), std::min(_depth, size_t(MAX_DEPTH)))), total(0),
+        counters(width * depth, 0), lock(std::make_unique<std::mutex>())
+    { }
+
+    CountMinSketch(CountMinSketch const& o) :
+        width(o.width), depth(o.depth), total(o.total), counters(o.counters), lock(std::make_unique<std::mutex>())
+    { }
+
+    CountMinSketch(CountMinSketch&& o) noexcept = default;
+
+    CountMinSketch& operator=(CountMinSketch const& o) {
+        if(this != &o) {
+            CountMinSketch tmp(o);
+            *this = std::move(tmp);
+        }
+
+        return *this;
+    }
+
+    CountMinSketch& operator=(CountMinSketch&& o) noexcept = default;
+
+    /**
+     * Add one to the count of each k-mer in the range [first, last), taking the lock only once for the whole batch.
+     * Safe to call concurrently from multiple threads.
+     *
+     * @return The highest estimated count among the batch
+     */
+    template<typename Iter>
+    count_type incrementBatch(Iter first, Iter last) {
+        count_type batch_max = 0;
+        std::array<size_t, MAX_DEPTH> cells;
+
+        std::lock_guard<std::mutex> guard(*lock);
+        for(; first != last; ++first) {
+            computeCells(*first, cells);
+            count_type estimate = minOf(cells);
+            count_type new_count = estimate < MAX_COUNT ? estimate + 1 : MAX_COUNT;
+
+            for(size_t row = 0; row < depth; ++row) {
+                counters[cells[row]] = std::max(counters[cells[row]], new_count);
+            }
+
+            ++total;
+            batch_max = std::max(batch_max, new_count);
+        }
+
+        return batch_max;
+    }
+
+    /**
+     * Add `amount` to the count of a k-mer. Safe to call concurrently from multiple threads.
+     *
+     * @return The new estimated count of the k-mer
+     */
+    count_type increment(Kmer const& kmer, count_type amount = 1) {
+        std::array<size_t, MAX_DEPTH> cells;
+        computeCells(kmer, cells);
+
+        std::lock_guard<std::mutex> guard(*lock);
+        count_type estimate = minOf(cells);
+        count_type new_count = estimate < MAX_COUNT - amount ? estimate + amount : MAX_COUNT;
+
+        for(size_t row = 0; row < depth; ++row) {
+            counters[cells[row]] = std::max(counters[cells[row]], new_count);
+        }
+
+        total += amount;
+        return new_count;
+    }
+
+    /**
+     * Estimated count of a k-mer. Not safe to call concurrently with `increment`.
+     */
+    count_type query(Kmer const& kmer) const {
+        std::array<size_t, MAX_DEPTH> cells;
+        computeCells(kmer, cells);
+
+        return minOf(cells);
+    }
+
+    /**
+     * Add all counters of a sketch with the same dimensions to this one. The result is still an upper bound of the
+     * true counts, but the estimates are those of a regular count-min sketch instead of a conservative one. Not safe
+     * to call concurrently with other writers.
+     */
+    void merge(CountMinSketch const& other) {
+        if(other.width != width || other.depth != depth) {
+            throw std::runtime_error("Can't merge count-min sketches with different dimensions.");
+        }
+
+        for(size_t i = 0; i < counters.size(); ++i) {
+            counters[i] = static_cast<count_type>(
+                std::min<uint64_t>(uint64_t(counters[i]) + other.counters[i], MAX_COUNT));
+        }
+
+        total += other.total;
+    }
+
+    /**
+     * Total of all counts added to this sketch.
+     */
+    uint64_t getTotal() const {
+        return total;
+    }
+
+    size_t getWidth() const {
+        return width;
+    }
+
+    size_t getDepth() const {
+        return depth;
+    }
+
+    template<typename Archive>
+    void save(Archive& ar) const {
+        ar(width, depth, total, counters);
+    }
+
+    template<typename Archive>
+    void load(Archive& ar) {
+        ar(width, depth, total, counters);
+
+        if(depth == 0 || depth > MAX_DEPTH || counters.size() != width * depth) {
+            throw std::runtime_error("Invalid count-min sketch dimensions in file.");
+        }
+    }
+
+private:
+    /**
+     * Index of the counter in each row, with double hashing from two k-mer hashes (Kirsch and Mitzenmacher, 2006).
+     */
+    void computeCells(Kmer const& kmer, std::array<size_t, MAX_DEPTH>& cells) const {
+        uint64_t h1 = kmer.hash(0x9E3779B97F4A7C15ULL);
+        uint64_t h2 = kmer.hash(0xC2B2AE3D27D4EB4FULL) | 1;
+
+        for(size_t row = 0; row < depth; ++row) {
+            cells[row] = row * width + ((h1 + row * h2) & (width - 1));
+        }
+    }
+
+    count_type minOf(std::array<size_t, MAX_DEPTH> const& cells) const {
+        count_type estimate = MAX_COUNT;
+        for(size_t row = 0; row < depth; ++row) {
+            estimate = std::min(estimate, counters[cells[row]]);
+        }
+
+        return estimate;
+    }
+
+    size_t width;
+    size_t depth;
+    uint64_t total;
+    std::vector<count_type> counters;
+    std::unique_ptr<std::mutex> lock;
+};
+
+}
+
+#endif //PYFROST_COUNTMINSKETCH_H
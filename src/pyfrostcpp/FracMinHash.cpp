@@ -0,0 +1,403 @@
+#include "FracMinHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <cereal/archives/binary.hpp>
+
+using std::vector;
+using std::string;
+
+namespace pyfrost {
+
+namespace {
+
+/**
+ * Run `func(i)` for all i in [0, n), with indices divided dynamically over `num_threads` threads.
+ */
+template<typename F>
+void parallelFor(size_t n, size_t num_threads, F&& func)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&] () {
+        for(size_t i = next++; i < n; i = next++) {
+            func(i);
+        }
+    };
+
+    vector<std::thread> threads;
+    for(size_t i = 1; i < std::min(std::max(size_t(1), num_threads), n); ++i) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+    for(auto& t : threads) {
+        t.join();
+    }
+}
+
+}
+
+constexpr size_t FracMinHash::MIN_DEDUPLICATE_SIZE;
+
+FracMinHash::FracMinHash(size_t _scale, uint64_t _seed, std::string _name) :
+    name(std::move(_name)), k(Kmer::k), scale(std::max(size_t(1), _scale)), seed(_seed),
+    threshold(computeThreshold(scale))
+{
+}
+
+uint64_t FracMinHash::computeThreshold(size_t scale)
+{
+    return scale <= 1 ? std::numeric_limits<uint64_t>::max() : std::numeric_limits<uint64_t>::max() / scale;
+}
+
+void FracMinHash::addSequence(std::string const& sequence, KmerScanner& scanner)
+{
+    size_t num_kmers = scanner.scan(sequence, true, false);
+    for(size_t i = 0; i < num_kmers; ++i) {
+        addHash(hashKmer(scanner.kmer(i)));
+    }
+}
+
+void FracMinHash::finalize()
+{
+    if(isFinalized()) {
+        return;
+    }
+
+    auto unsorted = hashes.begin() + num_sorted;
+    std::sort(unsorted, hashes.end());
+    std::inplace_merge(hashes.begin(), unsorted, hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    num_sorted = hashes.size();
+}
+
+FracMinHash& FracMinHash::merge(FracMinHash const& o)
+{
+    checkCompatible(o);
+
+    // A sketch merged with itself doesn't change, and inserting a vector's elements into itself is undefined
+    if(&o == this) {
+        finalize();
+        return *this;
+    }
+
+    // `o` may not be finalized, so add its hashes as unsorted hashes
+    hashes.insert(hashes.end(), o.hashes.begin(), o.hashes.end());
+    finalize();
+
+    return *this;
+}
+
+size_t FracMinHash::intersectionSize(FracMinHash const& o) const
+{
+    checkCompatible(o);
+    checkFinalized(o);
+
+    size_t shared = 0;
+    auto a = hashes.begin();
+    auto b = o.hashes.begin();
+    while(a != hashes.end() && b != o.hashes.end()) {
+        if(*a < *b) {
+            ++a;
+        } else if(*b < *a) {
+            ++b;
+        } else {
+            ++shared;
+            ++a;
+            ++b;
+        }
+    }
+
+    return shared;
+}
+
+double FracMinHash::jaccard(FracMinHash const& o) const
+{
+    size_t shared = intersectionSize(o);
+    size_t total = hashes.size() + o.hashes.size() - shared;
+
+    return total > 0 ? static_cast<double>(shared) / total : 0.0;
+}
+
+double FracMinHash::containment(FracMinHash const& o) const
+{
+    size_t shared = intersectionSize(o);
+
+    return !hashes.empty() ? static_cast<double>(shared) / hashes.size() : 0.0;
+}
+
+void FracMinHash::checkCompatible(FracMinHash const& o) const
+{
+    if(k != o.k || scale != o.scale || seed != o.seed) {
+        throw std::runtime_error("Can't compare sketches with different k-mer size, scale or seed.");
+    }
+}
+
+void FracMinHash::checkFinalized(FracMinHash const& o) const
+{
+    if(!isFinalized() || !o.isFinalized()) {
+        throw std::runtime_error("Sketches must be finalized before comparing them.");
+    }
+}
+
+std::vector<FracMinHash> sketchFiles(std::vector<std::string> const& files, size_t scale, uint64_t seed,
+                                     size_t num_threads)
+{
+    vector<FracMinHash> sketches;
+    for(auto const& file : files) {
+        sketches.emplace_back(scale, seed, file);
+    }
+
+    parallelFor(files.size(), num_threads, [&] (size_t file_ix) {
+        KmerScanner scanner;
+        FileParser fp(vector<string> {files[file_ix]});
+
+        string sequence;
+        size_t fp_file_ix = 0;
+        while(fp.read(sequence, fp_file_ix)) {
+            sketches[file_ix].addSequence(sequence, scanner);
+        }
+
+        fp.close();
+        sketches[file_ix].finalize();
+    });
+
+    return sketches;
+}
+
+std::vector<FracMinHash> sketchColors(PyfrostCCDBG& graph, size_t scale, uint64_t seed, size_t num_threads)
+{
+    FracMinHash sampler(scale, seed);
+    vector<FracMinHash> sketches;
+    for(auto const& color_name : graph.getData()->getColorNames()) {
+        sketches.emplace_back(scale, seed, color_name);
+    }
+
+    vector<PyfrostColoredUMap> unitigs;
+    for(auto const& unitig : graph) {
+        unitigs.push_back(unitig);
+    }
+
+    num_threads = std::max(size_t(1), num_threads);
+    size_t block_size = std::max(size_t(1), unitigs.size() / (num_threads * 8));
+    size_t num_blocks = (unitigs.size() + block_size - 1) / block_size;
+
+    // Each block collects the kept hashes per color. Only a small fraction of the k-mers is kept, so the color lookup
+    // is done for those k-mers only.
+    vector<vector<vector<uint64_t>>> block_hashes(num_blocks);
+    parallelFor(num_blocks, num_threads, [&] (size_t block_ix) {
+        auto& color_hashes = block_hashes[block_ix];
+        color_hashes.resize(sketches.size());
+
+        KmerScanner scanner;
+        size_t end = std::min(unitigs.size(), (block_ix + 1) * block_size);
+        for(size_t unitig_ix = block_ix * block_size; unitig_ix < end; ++unitig_ix) {
+            auto const& unitig = unitigs[unitig_ix];
+            auto colorset = unitig.getData()->getUnitigColors(unitig);
+            if(colorset == nullptr) {
+                continue;
+            }
+
+            size_t num_kmers = scanner.scan(unitig.referenceUnitigToString(), true, false);
+            for(size_t i = 0; i < num_kmers; ++i) {
+                uint64_t hash = sampler.hashKmer(scanner.kmer(i));
+                if(!sampler.keeps(hash)) {
+                    continue;
+                }
+
+                auto kmer_map = unitig.getKmerMapping(scanner.position(i));
+                for(auto it = colorset->begin(kmer_map); it != colorset->end(); it.nextColor()) {
+                    color_hashes[it.getColorID()].push_back(hash);
+                }
+            }
+        }
+    });
+
+    parallelFor(sketches.size(), num_threads, [&] (size_t color_id) {
+        for(auto& color_hashes : block_hashes) {
+            for(uint64_t hash : color_hashes[color_id]) {
+                sketches[color_id].addHash(hash);
+            }
+
+            vector<uint64_t>().swap(color_hashes[color_id]);
+        }
+
+        sketches[color_id].finalize();
+    });
+
+    return sketches;
+}
+
+std::vector<double> compareSketches(std::vector<FracMinHash const*> const& queries,
+                                    std::vector<FracMinHash const*> const& references, bool containment,
+                                    size_t num_threads)
+{
+    vector<double> matrix(queries.size() * references.size());
+
+    parallelFor(queries.size(), num_threads, [&] (size_t row) {
+        for(size_t col = 0; col < references.size(); ++col) {
+            matrix[row * references.size() + col] = containment ? queries[row]->containment(*references[col])
+                                                                : queries[row]->jaccard(*references[col]);
+        }
+    });
+
+    return matrix;
+}
+
+void define_FracMinHash(py::module& m) {
+    py::class_<FracMinHash>(m, "FracMinHash", py::module_local(),
+                            "Scaled MinHash sketch of the canonical k-mers in a sample.")
+        .def(py::init<size_t, uint64_t, string>(), py::arg("scale") = 1000, py::arg("seed") = 42,
+            py::arg("name") = "")
+
+        // Hashes are sorted lazily, only when the sketch is compared or its hashes are accessed
+        .def("add_sequence", [] (FracMinHash& self, string const& sequence) {
+            KmerScanner scanner;
+            self.addSequence(sequence, scanner);
+        }, py::arg("sequence"))
+        .def("merge", &FracMinHash::merge, py::return_value_policy::reference_internal,
+            "Add all k-mers of another sketch.")
+
+        .def("jaccard", [] (FracMinHash& self, FracMinHash& other) {
+            self.finalize();
+            other.finalize();
+
+            return self.jaccard(other);
+        }, py::arg("other"), "Estimated Jaccard index of the k-mer sets.")
+        .def("containment", [] (FracMinHash& self, FracMinHash& other) {
+            self.finalize();
+            other.finalize();
+
+            return self.containment(other);
+        }, py::arg("other"), "Estimated fraction of the k-mers in this sketch that are also in `other`.")
+        .def("intersection_size", [] (FracMinHash& self, FracMinHash& other) {
+            self.finalize();
+            other.finalize();
+
+            return self.intersectionSize(other);
+        }, py::arg("other"))
+
+        .def_property("name", &FracMinHash::getName, &FracMinHash::setName)
+        .def_property_readonly("k", &FracMinHash::getK)
+        .def_property_readonly("scale", &FracMinHash::getScale)
+        .def_property_readonly("seed", &FracMinHash::getSeed)
+        .def_property_readonly("hashes", [] (FracMinHash& self) {
+            self.finalize();
+
+            return as_pyarray(vector<uint64_t>(self.getHashes()));
+        })
+        .def("__len__", [] (FracMinHash& self) {
+            self.finalize();
+
+            return self.size();
+        })
+        .def("__repr__", [] (FracMinHash& self) {
+            self.finalize();
+
+            return "<FracMinHash '" + self.getName() + "' k=" + std::to_string(self.getK()) + " scale="
+                + std::to_string(self.getScale()) + " hashes=" + std::to_string(self.size()) + ">";
+        });
+
+    m.def("sketch_files", &sketchFiles, py::arg("files"), py::arg("scale") = 1000, py::arg("seed") = 42,
+          py::arg("threads") = 2, py::call_guard<py::gil_scoped_release>(),
+          "Build a sketch for each FASTA/FASTQ file, in parallel.");
+
+    m.def("sketch_colors", &sketchColors, py::arg("graph"), py::arg("scale") = 1000, py::arg("seed") = 42,
+          py::arg("threads") = 2, py::call_guard<py::gil_scoped_release>(),
+          "Build a sketch for each color in a colored graph, in parallel.");
+
+    // Sketches are taken by pointer, so they're finalized in place and not copied
+    auto compare = [] (vector<FracMinHash*> const& queries, vector<FracMinHash*> const& references, bool containment,
+                       size_t num_threads) {
+        vector<FracMinHash const*> query_sketches(queries.begin(), queries.end());
+        vector<FracMinHash const*> reference_sketches(references.begin(), references.end());
+        for(auto sketch : query_sketches) {
+            if(sketch == nullptr) {
+                throw py::type_error("Expected a list of FracMinHash sketches.");
+            }
+        }
+
+        for(auto sketch : reference_sketches) {
+            if(sketch == nullptr) {
+                throw py::type_error("Expected a list of FracMinHash sketches.");
+            }
+        }
+
+        vector<double> matrix;
+        {
+            py::gil_scoped_release release;
+
+            // The same sketch can occur more than once, so finalize on this thread only
+            for(auto sketch : queries) {
+                sketch->finalize();
+            }
+
+            for(auto sketch : references) {
+                sketch->finalize();
+            }
+
+            matrix = compareSketches(query_sketches, reference_sketches, containment, num_threads);
+        }
+
+        return as_pyarray(std::move(matrix), {queries.size(), references.size()});
+    };
+
+    m.def("jaccard_matrix", [compare] (vector<FracMinHash*> const& sketches, py::object const& others,
+                                       size_t threads) {
+        if(others.is_none()) {
+            return compare(sketches, sketches, false, threads);
+        }
+
+        return compare(sketches, others.cast<vector<FracMinHash*>>(), false, threads);
+    }, py::arg("sketches"), py::arg("others") = py::none(), py::arg("threads") = 2,
+        "Jaccard index of each sketch in `sketches` (rows) to each sketch in `others` (columns), or all-vs-all if "
+        "`others` is not given.");
+
+    m.def("containment_matrix", [compare] (vector<FracMinHash*> const& sketches, py::object const& others,
+                                           size_t threads) {
+        if(others.is_none()) {
+            return compare(sketches, sketches, true, threads);
+        }
+
+        return compare(sketches, others.cast<vector<FracMinHash*>>(), true, threads);
+    }, py::arg("sketches"), py::arg("others") = py::none(), py::arg("threads") = 2,
+        "Containment of each sketch in `sketches` (rows) in each sketch in `others` (columns), or all-vs-all if "
+        "`others` is not given.");
+
+    m.def("save_sketches", [] (vector<FracMinHash> const& sketches, string const& filepath) {
+        std::ofstream ofile(filepath, std::ios::binary);
+        if(!ofile) {
+            throw std::runtime_error("Could not open " + filepath + " for writing.");
+        }
+
+        {
+            cereal::BinaryOutputArchive archive(ofile);
+            archive(sketches);
+        }
+
+        ofile.close();
+        if(!ofile) {
+            throw std::runtime_error("Error while writing " + filepath + ".");
+        }
+    }, py::arg("sketches"), py::arg("filepath"));
+
+    m.def("load_sketches", [] (string const& filepath) {
+        std::ifstream ifile(filepath, std::ios::binary);
+        if(!ifile) {
+            throw std::runtime_error("Could not open " + filepath + ".");
+        }
+
+        cereal::BinaryInputArchive archive(ifile);
+
+        vector<FracMinHash> sketches;
+        archive(sketches);
+
+        return sketches;
+    }, py::arg("filepath"));
+}
+
+}
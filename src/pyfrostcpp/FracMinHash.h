@@ -0,0 +1,191 @@
+/**
+ * Scaled MinHash (FracMinHash) sketches of k-mer sets.
+ *
+ * A sketch keeps the hashes of all canonical k-mers with a hash below `2^64 / scale`, on average one in `scale`
+ * distinct k-mers. Unlike a bottom-k MinHash, the sketch size grows with the number of distinct k-mers, so
+ * containment between sets of very different sizes can be estimated without bias.
+ *
+ * Sketches can be built per FASTA/FASTQ file, or per color of a colored graph, and compared all-vs-all on multiple
+ * threads.
+ */
+
+#ifndef PYFROST_FRACMINHASH_H
+#define PYFROST_FRACMINHASH_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+#include "KmerScanner.h"
+#include "Serialize.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace pyfrost {
+
+class FracMinHash {
+public:
+    /**
+     * @param scale Keep on average one in `scale` k-mers
+     * @param seed Seed of the k-mer hash function, only sketches with the same seed can be compared
+     * @param name Name of the sketched sample, e.g., a file name or color name
+     */
+    FracMinHash(size_t scale=1000, uint64_t seed=42, std::string name="");
+
+    /**
+     * Add all canonical k-mers of a sequence. New hashes are sorted lazily, call `finalize` before comparing sketches.
+     */
+    void addSequence(std::string const& sequence, KmerScanner& scanner);
+
+    /**
+     * Whether a k-mer with the given hash is part of the sketch.
+     */
+    bool keeps(uint64_t hash) const {
+        return hash < threshold;
+    }
+
+    void addHash(uint64_t hash) {
+        if(!keeps(hash)) {
+            return;
+        }
+
+        hashes.push_back(hash);
+
+        // Deduplicate once the unsorted hashes outnumber the sorted ones, so inputs with many repeated k-mers use
+        // memory proportional to the number of distinct k-mers
+        if(hashes.size() - num_sorted > std::max(num_sorted, MIN_DEDUPLICATE_SIZE)) {
+            finalize();
+        }
+    }
+
+    uint64_t hashKmer(Kmer const& canonical) const {
+        return canonical.hash(seed);
+    }
+
+    /**
+     * Sort the hashes added since the last call and merge them into the sorted, deduplicated hashes. Cheap if no
+     * hashes were added.
+     */
+    void finalize();
+
+    bool isFinalized() const {
+        return num_sorted == hashes.size();
+    }
+
+    /**
+     * Add all hashes of another sketch, e.g., to combine sketches of multiple files.
+     */
+    FracMinHash& merge(FracMinHash const& o);
+
+    /**
+     * Number of shared hashes. This and the comparisons below require both sketches to be finalized.
+     */
+    size_t intersectionSize(FracMinHash const& o) const;
+
+    /**
+     * Estimated Jaccard index of the two k-mer sets.
+     */
+    double jaccard(FracMinHash const& o) const;
+
+    /**
+     * Estimated fraction of the k-mers in this set that are also in `o`.
+     */
+    double containment(FracMinHash const& o) const;
+
+    std::string const& getName() const {
+        return name;
+    }
+
+    void setName(std::string const& _name) {
+        name = _name;
+    }
+
+    size_t getK() const {
+        return k;
+    }
+
+    size_t getScale() const {
+        return scale;
+    }
+
+    uint64_t getSeed() const {
+        return seed;
+    }
+
+    /**
+     * Number of hashes, which may include duplicates if the sketch isn't finalized.
+     */
+    size_t size() const {
+        return hashes.size();
+    }
+
+    std::vector<uint64_t> const& getHashes() const {
+        return hashes;
+    }
+
+    template<typename Archive>
+    void save(Archive& ar) const {
+        ar(name, k, scale, seed, hashes);
+    }
+
+    template<typename Archive>
+    void load(Archive& ar) {
+        ar(name, k, scale, seed, hashes);
+        threshold = computeThreshold(scale);
+
+        // Sketches may have been saved before they were finalized
+        num_sorted = 0;
+        finalize();
+    }
+
+private:
+    static constexpr size_t MIN_DEDUPLICATE_SIZE = 1 << 16;
+
+    static uint64_t computeThreshold(size_t scale);
+
+    /**
+     * Throws if the sketches were built with a different k, scale or seed.
+     */
+    void checkCompatible(FracMinHash const& o) const;
+
+    /**
+     * Throws if either sketch isn't finalized.
+     */
+    void checkFinalized(FracMinHash const& o) const;
+
+    std::string name;
+    size_t k;
+    size_t scale;
+    uint64_t seed;
+    uint64_t threshold;
+
+    /// The first `num_sorted` hashes are sorted and distinct, hashes added after the last `finalize` follow unsorted
+    std::vector<uint64_t> hashes;
+    size_t num_sorted = 0;
+};
+
+/**
+ * Sketch each file separately, with files divided over `num_threads` threads.
+ */
+std::vector<FracMinHash> sketchFiles(std::vector<std::string> const& files, size_t scale, uint64_t seed,
+                                     size_t num_threads);
+
+/**
+ * Sketch the k-mers of each color in a colored graph, with unitigs divided over `num_threads` threads.
+ */
+std::vector<FracMinHash> sketchColors(PyfrostCCDBG& graph, size_t scale, uint64_t seed, size_t num_threads);
+
+/**
+ * Compare each query sketch to each reference sketch, returns a row-major matrix with a row per query. Computes
+ * the containment of the query in the reference if `containment` is true, the Jaccard index otherwise. All sketches
+ * must be finalized.
+ */
+std::vector<double> compareSketches(std::vector<FracMinHash const*> const& queries,
+                                    std::vector<FracMinHash const*> const& references, bool containment,
+                                    size_t num_threads);
+
+void define_FracMinHash(py::module& m);
+
+}
+
+#endif //PYFROST_FRACMINHASH_H
@@ -0,0 +1,132 @@
+#include "FrozenKmerCounter.h"
+
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <cereal/archives/binary.hpp>
+
+using std::vector;
+using std::string;
+using std::thread;
+
+namespace pyfrost {
+
+template<typename T>
+constexpr T FrozenKmerCounter<T>::MAX_STORED;
+
+template<typename T>
+FrozenKmerCounter<T>::FrozenKmerCounter(size_t _k, size_t _g, bool _canonical, vector<Kmer> const& keys,
+                                        vector<count_type> const& counts, uint64_t _num_kmers, count_type _max_count,
+                                        size_t num_threads) :
+    k(_k), g(_g), canonical(_canonical), num_kmers(_num_kmers), max_count(_max_count),
+    mphf(keys, num_threads), entries(keys.size())
+{
+    num_threads = std::max(size_t(1), num_threads);
+    size_t chunk_size = (keys.size() + num_threads - 1) / num_threads;
+
+    vector<vector<std::pair<uint64_t, count_type>>> thread_overflow(num_threads);
+    vector<thread> threads;
+    for(size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] () {
+            size_t end = std::min(keys.size(), (t + 1) * chunk_size);
+            for(size_t i = t * chunk_size; i < end; ++i) {
+                size_t ix = mphf.lookup(keys[i]);
+
+                entries[ix].fingerprint = fingerprint(keys[i]);
+                entries[ix].count = static_cast<T>(std::min<count_type>(counts[i], MAX_STORED));
+
+                if(KmerCountTraits<T>::has_overflow && counts[i] >= MAX_STORED) {
+                    thread_overflow[t].emplace_back(ix, counts[i]);
+                }
+            }
+        });
+    }
+
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    for(auto const& v : thread_overflow) {
+        overflow.insert(overflow.end(), v.begin(), v.end());
+    }
+
+    std::sort(overflow.begin(), overflow.end());
+}
+
+template<typename T>
+typename FrozenKmerCounter<T>::count_type FrozenKmerCounter<T>::query(Kmer const& qry) const
+{
+    Kmer kmer = canonical ? qry.rep() : qry;
+
+    size_t ix = mphf.lookup(kmer);
+    if(ix == KmerMPHF::NOT_FOUND) {
+        return 0;
+    }
+
+    Entry const& entry = entries[ix];
+    if(entry.fingerprint != fingerprint(kmer)) {
+        return 0;
+    }
+
+    if(KmerCountTraits<T>::has_overflow && entry.count == MAX_STORED) {
+        auto it = std::lower_bound(overflow.begin(), overflow.end(), std::make_pair(uint64_t(ix), count_type(0)));
+        if(it != overflow.end() && it->first == ix) {
+            return it->second;
+        }
+    }
+
+    return entry.count;
+}
+
+template<typename T>
+typename FrozenKmerCounter<T>::count_type FrozenKmerCounter<T>::query(char const* qry) const
+{
+    return query(Kmer(qry));
+}
+
+
+template<typename T>
+void define_FrozenKmerCounter(py::module& m, char const* name) {
+    py::class_<FrozenKmerCounter<T>>(m, name, py::module_local())
+        .def("query", py::overload_cast<Kmer const&>(&FrozenKmerCounter<T>::query, py::const_))
+        .def("query", py::overload_cast<char const*>(&FrozenKmerCounter<T>::query, py::const_))
+
+        .def("__getitem__", py::overload_cast<Kmer const&>(&FrozenKmerCounter<T>::query, py::const_))
+        .def("__getitem__", py::overload_cast<char const*>(&FrozenKmerCounter<T>::query, py::const_))
+
+        .def("__len__", [] (FrozenKmerCounter<T> const& self) {
+            return self.getUniqueKmers();
+        })
+
+        .def_property_readonly("num_kmers", &FrozenKmerCounter<T>::getNumKmers)
+        .def_property_readonly("num_unique", &FrozenKmerCounter<T>::getUniqueKmers)
+        .def_property_readonly("max_count", &FrozenKmerCounter<T>::getMaxCount)
+
+        .def("save", [] (FrozenKmerCounter<T>& self, string const& filepath) {
+            std::ofstream ofile(filepath, std::ios::binary);
+            cereal::BinaryOutputArchive archive(ofile);
+
+            archive(cereal::make_nvp("frozenkmercounter", self));
+        })
+
+        .def_static("from_file", [] (string const& filepath) {
+            FrozenKmerCounter<T> kmer_counter;
+
+            std::ifstream ifile(filepath, std::ios::binary);
+            cereal::BinaryInputArchive archive(ifile);
+
+            archive(kmer_counter);
+
+            return kmer_counter;
+        });
+}
+
+template class FrozenKmerCounter<uint8_t>;
+template class FrozenKmerCounter<uint16_t>;
+template class FrozenKmerCounter<uint32_t>;
+
+template void define_FrozenKmerCounter<uint8_t>(py::module& m, char const* name);
+template void define_FrozenKmerCounter<uint16_t>(py::module& m, char const* name);
+template void define_FrozenKmerCounter<uint32_t>(py::module& m, char const* name);
+
+}
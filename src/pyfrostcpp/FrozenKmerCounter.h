@@ -0,0 +1,118 @@
+/**
+ * Read-only k-mer counts, created with `KmerCounter::freeze()`.
+ *
+ * K-mers are mapped to an index with a minimal perfect hash function, which indexes a packed array of
+ * (fingerprint, count) entries. The k-mers themselves are not stored: the fingerprint is used to reject k-mers that
+ * were not counted, with a false positive rate of about 1 in 65,536.
+ */
+
+#ifndef PYFROST_FROZENKMERCOUNTER_H
+#define PYFROST_FROZENKMERCOUNTER_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+#include "KmerMPHF.h"
+#include "KmerCountTable.h"
+
+#include <cereal/types/utility.hpp>
+
+namespace pyfrost {
+
+template<typename T>
+class FrozenKmerCounter {
+public:
+    using count_type = typename KmerCountTraits<T>::count_type;
+
+    FrozenKmerCounter() : k(DEFAULT_K), g(0), canonical(true), num_kmers(0), max_count(0) { }
+
+    /**
+     * Build the index from the given k-mers and their counts.
+     *
+     * @param keys Unique k-mers
+     * @param counts Count for each k-mer in `keys`
+     */
+    FrozenKmerCounter(size_t k, size_t g, bool canonical, std::vector<Kmer> const& keys,
+                      std::vector<count_type> const& counts, uint64_t num_kmers, count_type max_count,
+                      size_t num_threads);
+
+    FrozenKmerCounter(FrozenKmerCounter const& o) = default;
+    FrozenKmerCounter(FrozenKmerCounter&& o) = default;
+
+    count_type query(Kmer const& qry) const;
+    count_type query(char const* qry) const;
+
+    uint64_t getNumKmers() const {
+        return num_kmers;
+    }
+
+    uint64_t getUniqueKmers() const {
+        return entries.size();
+    }
+
+    count_type getMaxCount() const {
+        return max_count;
+    }
+
+    template<typename Archive>
+    void save(Archive& ar) const {
+        ar(k, g, canonical);
+        save_count_width<T>(ar);
+        ar(num_kmers, max_count, mphf);
+
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(entries.size())));
+        ar(cereal::binary_data(entries.data(), entries.size() * sizeof(Entry)));
+
+        ar(overflow);
+    }
+
+    template<typename Archive>
+    void load(Archive& ar) {
+        ar(k, g, canonical);
+        setKG(k, g);
+
+        // Counters saved before the count width was recorded have the number of k-mers in its place
+        if(load_count_width<T>(ar, num_kmers)) {
+            ar(num_kmers);
+        }
+
+        ar(max_count, mphf);
+
+        cereal::size_type num_entries;
+        ar(cereal::make_size_tag(num_entries));
+        entries.resize(num_entries);
+        ar(cereal::binary_data(entries.data(), entries.size() * sizeof(Entry)));
+
+        ar(overflow);
+    }
+
+private:
+    static constexpr T MAX_STORED = std::numeric_limits<T>::max();
+
+    struct Entry {
+        uint16_t fingerprint;
+        T count;
+    };
+
+    static uint16_t fingerprint(Kmer const& kmer) {
+        return static_cast<uint16_t>(kmer.hash(0xC2B2AE3D27D4EB4FULL) >> 48);
+    }
+
+    size_t k;
+    size_t g;
+    bool canonical;
+    uint64_t num_kmers;
+    count_type max_count;
+
+    KmerMPHF mphf;
+    std::vector<Entry> entries;
+
+    /// For 8-bit counts: (index, count) pairs sorted by index, for counts that don't fit in an entry
+    std::vector<std::pair<uint64_t, count_type>> overflow;
+};
+
+template<typename T>
+void define_FrozenKmerCounter(py::module& m, char const* name);
+
+}
+
+#endif //PYFROST_FROZENKMERCOUNTER_H
@@ -0,0 +1,788 @@
+#include "GraphSnapshot.h"
+#include "KmerScanner.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::vector;
+using std::string;
+using std::thread;
+
+namespace pyfrost {
+
+constexpr char GraphSnapshotHeader::MAGIC[8];
+constexpr uint32_t GraphSnapshotHeader::VERSION;
+constexpr uint32_t GraphSnapshotKmerRef::FORWARD_BIT;
+
+namespace {
+
+constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+/// Largest prefix index, 2^28 groups take 2 GB
+constexpr uint32_t MAX_PREFIX_BITS = 28;
+
+/// Targeted average number of k-mers per prefix group
+constexpr uint64_t KMERS_PER_GROUP = 16;
+
+/// Targeted number of k-mers per spill bucket, `num_threads` buckets are sorted in memory at once
+constexpr uint64_t KMERS_PER_BUCKET = uint64_t(1) << 22;
+
+/// Largest number of spill buckets, each thread keeps a write buffer per bucket
+constexpr uint32_t MAX_BUCKET_BITS = 10;
+
+constexpr size_t SPILL_BUFFER_RECORDS = 512;
+
+/**
+ * A canonical k-mer and its location in the graph, as stored in the spill buckets while writing a snapshot.
+ */
+struct SpillRecord {
+    uint64_t words[KMER_WORDS];
+    uint64_t prefix;
+    GraphSnapshotKmerRef ref;
+};
+
+/**
+ * Temporary file that multiple threads append to, removed when destroyed.
+ */
+class SpillFile {
+public:
+    explicit SpillFile(string _path) : path(std::move(_path)), file(path, std::ios::binary | std::ios::trunc), size(0)
+    {
+        if(!file) {
+            throw std::runtime_error("Could not create temporary file " + path);
+        }
+    }
+
+    ~SpillFile() {
+        file.close();
+        std::remove(path.c_str());
+    }
+
+    /**
+     * Append `num_bytes` bytes, returns the offset they were written at.
+     */
+    uint64_t append(void const* data, size_t num_bytes) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        uint64_t offset = size;
+        file.write(static_cast<char const*>(data), num_bytes);
+        size += num_bytes;
+
+        return offset;
+    }
+
+    uint64_t append(vector<SpillRecord> const& records) {
+        return append(records.data(), records.size() * sizeof(SpillRecord));
+    }
+
+    /**
+     * Stop writing, and open the file for reading.
+     */
+    std::ifstream openForReading() {
+        file.close();
+        if(file.fail()) {
+            throw std::runtime_error("Error while writing temporary file " + path);
+        }
+
+        std::ifstream in(path, std::ios::binary);
+        if(!in) {
+            throw std::runtime_error("Could not open temporary file " + path);
+        }
+
+        return in;
+    }
+
+    /**
+     * Read all records of a bucket file, and remove the file.
+     */
+    void readAll(vector<SpillRecord>& records) {
+        {
+            std::ifstream in = openForReading();
+            records.resize(size / sizeof(SpillRecord));
+            if(!in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(SpillRecord))) {
+                throw std::runtime_error("Error while reading temporary file " + path);
+            }
+        }
+
+        std::remove(path.c_str());
+    }
+
+    uint64_t getSize() const {
+        return size;
+    }
+
+private:
+    string path;
+    std::ofstream file;
+    std::mutex lock;
+    uint64_t size;
+};
+
+string spillPathPrefix(string const& tmp_dir) {
+    string dir = tmp_dir;
+    if(dir.empty()) {
+        char const* env_tmp = std::getenv("TMPDIR");
+        dir = env_tmp != nullptr ? env_tmp : "/tmp";
+    }
+
+    static std::atomic<size_t> counter(0);
+
+    std::stringstream prefix;
+    prefix << dir << "/pyfrost_snapshot." << getpid() << "." << counter++ << ".";
+
+    return prefix.str();
+}
+
+/**
+ * Copy `num_bytes` bytes at `offset` in `in` to the current position of `out`.
+ */
+void copyRange(std::ifstream& in, uint64_t offset, uint64_t num_bytes, std::ofstream& out) {
+    vector<char> buffer(std::min(num_bytes, uint64_t(1) << 20));
+
+    in.seekg(offset);
+    while(num_bytes > 0) {
+        size_t chunk = std::min(num_bytes, static_cast<uint64_t>(buffer.size()));
+        if(!in.read(buffer.data(), chunk)) {
+            throw std::runtime_error("Error while reading temporary file.");
+        }
+
+        out.write(buffer.data(), chunk);
+        num_bytes -= chunk;
+    }
+}
+
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+uint64_t prefixOf(Kmer const& kmer, uint32_t prefix_bits) {
+    return prefix_bits > 0 ? kmer.hash() >> (64 - prefix_bits) : 0;
+}
+
+/**
+ * Compare two k-mers on their packed words, returns a negative value, zero or a positive value like `memcmp`.
+ */
+int compareWords(uint64_t const* a, uint64_t const* b) {
+    for(size_t w = 0; w < KMER_WORDS; ++w) {
+        if(a[w] != b[w]) {
+            return a[w] < b[w] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+void writePadding(std::ofstream& ofile, uint64_t offset) {
+    static char const zeros[SECTION_ALIGNMENT] = {};
+    ofile.write(zeros, alignOffset(offset) - offset);
+}
+
+template<typename T>
+void writeSection(std::ofstream& ofile, uint64_t offset, T const* values, size_t num_values) {
+    ofile.write(reinterpret_cast<char const*>(values), num_values * sizeof(T));
+    writePadding(ofile, offset + num_values * sizeof(T));
+}
+
+}
+
+void GraphSnapshot::write(PyfrostCCDBG& graph, string const& filepath, size_t num_threads, string const& tmp_dir)
+{
+    num_threads = std::max(size_t(1), num_threads);
+
+    vector<PyfrostColoredUMap> unitigs;
+    uint64_t num_kmers = 0;
+    for(auto const& unitig : graph) {
+        unitigs.push_back(unitig);
+        num_kmers += unitig.size - graph.getK() + 1;
+    }
+
+    if(unitigs.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Graph has too many unitigs for a snapshot.");
+    }
+
+    uint32_t prefix_bits = 0;
+    while(prefix_bits < MAX_PREFIX_BITS && (KMERS_PER_GROUP << (prefix_bits + 1)) <= num_kmers) {
+        ++prefix_bits;
+    }
+
+    // Each bucket holds the k-mers of a range of consecutive prefix groups
+    uint32_t bucket_bits = 0;
+    while(bucket_bits < std::min(prefix_bits, MAX_BUCKET_BITS) && (KMERS_PER_BUCKET << bucket_bits) < num_kmers) {
+        ++bucket_bits;
+    }
+
+    size_t num_buckets = size_t(1) << bucket_bits;
+    string path_prefix = spillPathPrefix(tmp_dir);
+
+    vector<std::unique_ptr<SpillFile>> buckets;
+    for(size_t i = 0; i < num_buckets; ++i) {
+        buckets.push_back(std::make_unique<SpillFile>(path_prefix + "bucket" + std::to_string(i)));
+    }
+
+    SpillFile sequences_file(path_prefix + "sequences");
+    SpillFile color_runs_file(path_prefix + "colors");
+
+    // Threads process blocks of consecutive unitigs. Each block's sequences and color runs are appended to a spill
+    // file, and copied to the snapshot in order of the blocks afterwards. K-mers are spilled to their bucket.
+    struct Block {
+        vector<uint64_t> lengths;
+        vector<uint64_t> num_color_runs;
+
+        uint64_t sequences_offset = 0;
+        uint64_t sequences_size = 0;
+        uint64_t color_runs_offset = 0;
+        uint64_t color_runs_size = 0;
+    };
+
+    size_t block_size = std::max(size_t(1), unitigs.size() / (num_threads * 8));
+    size_t num_blocks = (unitigs.size() + block_size - 1) / block_size;
+    vector<Block> blocks(num_blocks);
+
+    std::atomic<size_t> next_block(0);
+    std::atomic<bool> too_long(false);
+    auto collect_blocks = [&] () {
+        KmerScanner scanner;
+        vector<std::pair<uint32_t, uint32_t>> colors_positions;
+        vector<vector<SpillRecord>> bucket_buffers(num_buckets);
+
+        string sequences;
+        vector<GraphSnapshotColorRun> color_runs;
+        for(size_t block_ix = next_block++; block_ix < num_blocks && !too_long; block_ix = next_block++) {
+            Block& block = blocks[block_ix];
+            size_t end = std::min(unitigs.size(), (block_ix + 1) * block_size);
+
+            sequences.clear();
+            color_runs.clear();
+            for(size_t unitig_ix = block_ix * block_size; unitig_ix < end; ++unitig_ix) {
+                auto const& unitig = unitigs[unitig_ix];
+                string sequence = unitig.referenceUnitigToString();
+                if(sequence.size() >= GraphSnapshotKmerRef::FORWARD_BIT) {
+                    too_long = true;
+                    break;
+                }
+
+                sequences += sequence;
+                block.lengths.push_back(sequence.size());
+
+                size_t num_unitig_kmers = scanner.scan(sequence, false, false);
+                for(size_t i = 0; i < num_unitig_kmers; ++i) {
+                    Kmer canonical = scanner.kmer(i).rep();
+                    auto position = static_cast<uint32_t>(scanner.position(i));
+                    if(canonical == scanner.kmer(i)) {
+                        position |= GraphSnapshotKmerRef::FORWARD_BIT;
+                    }
+
+                    SpillRecord record = {};
+                    kmer_to_words(canonical, record.words);
+                    record.prefix = prefixOf(canonical, prefix_bits);
+                    record.ref = {static_cast<uint32_t>(unitig_ix), position};
+
+                    auto& buffer = bucket_buffers[record.prefix >> (prefix_bits - bucket_bits)];
+                    buffer.push_back(record);
+                    if(buffer.size() >= SPILL_BUFFER_RECORDS) {
+                        buckets[record.prefix >> (prefix_bits - bucket_bits)]->append(buffer);
+                        buffer.clear();
+                    }
+                }
+
+                // Bifrost iterates over colors per k-mer position, collapse them to runs of consecutive positions
+                size_t num_runs_before = color_runs.size();
+                auto colorset = unitig.getData()->getUnitigColors(unitig);
+                if(colorset != nullptr) {
+                    colors_positions.clear();
+                    for(auto it = colorset->begin(unitig); it != colorset->end(); ++it) {
+                        colors_positions.emplace_back(static_cast<uint32_t>(it.getColorID()),
+                                                      static_cast<uint32_t>(it.getKmerPosition()));
+                    }
+
+                    std::sort(colors_positions.begin(), colors_positions.end());
+                    for(auto const& color_position : colors_positions) {
+                        if(color_runs.size() > num_runs_before && color_runs.back().color == color_position.first
+                           && color_runs.back().end == color_position.second) {
+                            ++color_runs.back().end;
+                        } else {
+                            color_runs.push_back({color_position.first, color_position.second,
+                                                  color_position.second + 1});
+                        }
+                    }
+                }
+
+                block.num_color_runs.push_back(color_runs.size() - num_runs_before);
+            }
+
+            block.sequences_size = sequences.size();
+            block.sequences_offset = sequences_file.append(sequences.data(), sequences.size());
+            block.color_runs_size = color_runs.size() * sizeof(GraphSnapshotColorRun);
+            block.color_runs_offset = color_runs_file.append(color_runs.data(), block.color_runs_size);
+        }
+
+        for(size_t bucket = 0; bucket < num_buckets; ++bucket) {
+            buckets[bucket]->append(bucket_buffers[bucket]);
+        }
+    };
+
+    {
+        vector<thread> threads;
+        for(size_t i = 1; i < std::min(num_threads, num_blocks); ++i) {
+            threads.emplace_back(collect_blocks);
+        }
+
+        collect_blocks();
+        for(auto& t : threads) {
+            t.join();
+        }
+    }
+
+    if(too_long) {
+        throw std::runtime_error("Graph has a unitig that is too long for a snapshot.");
+    }
+
+    vector<uint64_t> unitig_index(1, 0);
+    vector<uint64_t> color_index(1, 0);
+    unitig_index.reserve(unitigs.size() + 1);
+    color_index.reserve(unitigs.size() + 1);
+
+    for(auto const& block : blocks) {
+        for(auto length : block.lengths) {
+            unitig_index.push_back(unitig_index.back() + length);
+        }
+
+        for(auto num_runs : block.num_color_runs) {
+            color_index.push_back(color_index.back() + num_runs);
+        }
+    }
+
+    vector<uint64_t> bucket_start(num_buckets + 1, 0);
+    for(size_t bucket = 0; bucket < num_buckets; ++bucket) {
+        bucket_start[bucket + 1] = bucket_start[bucket] + buckets[bucket]->getSize() / sizeof(SpillRecord);
+    }
+
+    if(bucket_start.back() != num_kmers) {
+        throw std::runtime_error("Number of k-mers in the graph doesn't match the unitig lengths.");
+    }
+
+    string names;
+    auto color_names = graph.getData()->getColorNames();
+    for(auto const& name : color_names) {
+        names += name;
+        names.push_back('\0');
+    }
+
+    GraphSnapshotHeader header = {};
+    std::copy(std::begin(GraphSnapshotHeader::MAGIC), std::end(GraphSnapshotHeader::MAGIC), header.magic);
+    header.version = GraphSnapshotHeader::VERSION;
+    header.k = static_cast<uint32_t>(graph.getK());
+    header.g = static_cast<uint32_t>(graph.getG());
+    header.kmer_words = KMER_WORDS;
+    header.prefix_bits = prefix_bits;
+    header.num_unitigs = unitigs.size();
+    header.num_kmers = num_kmers;
+    header.num_colors = color_names.size();
+    header.num_color_runs = color_index.back();
+    header.names_size = names.size();
+    header.sequences_size = unitig_index.back();
+
+    uint64_t num_groups = uint64_t(1) << prefix_bits;
+    header.names_offset = alignOffset(sizeof(GraphSnapshotHeader));
+    header.unitig_index_offset = alignOffset(header.names_offset + names.size());
+    header.sequences_offset = alignOffset(header.unitig_index_offset + unitig_index.size() * sizeof(uint64_t));
+    header.index_offset = alignOffset(header.sequences_offset + header.sequences_size);
+    header.kmers_offset = alignOffset(header.index_offset + (num_groups + 1) * sizeof(uint64_t));
+    header.refs_offset = alignOffset(header.kmers_offset + num_kmers * KMER_WORDS * sizeof(uint64_t));
+    header.color_index_offset = alignOffset(header.refs_offset + num_kmers * sizeof(GraphSnapshotKmerRef));
+    header.color_runs_offset = alignOffset(header.color_index_offset + color_index.size() * sizeof(uint64_t));
+
+    std::ofstream ofile(filepath, std::ios::binary);
+    if(!ofile) {
+        throw std::runtime_error("Could not open " + filepath + " for writing.");
+    }
+
+    writeSection(ofile, 0, &header, 1);
+    writeSection(ofile, header.names_offset, names.data(), names.size());
+    writeSection(ofile, header.unitig_index_offset, unitig_index.data(), unitig_index.size());
+
+    {
+        std::ifstream sequences_in = sequences_file.openForReading();
+        for(auto const& block : blocks) {
+            copyRange(sequences_in, block.sequences_offset, block.sequences_size, ofile);
+        }
+    }
+
+    writePadding(ofile, header.sequences_offset + header.sequences_size);
+
+    // The index follows from the sorted k-mers, so it's written after the k-mers and their locations. Buckets are
+    // sorted in parallel, with at most `num_threads` buckets in memory at once.
+    vector<uint64_t> index(num_groups + 1, 0);
+    vector<vector<SpillRecord>> sorted(std::min(num_threads, num_buckets));
+    vector<uint64_t> words_buffer;
+    vector<GraphSnapshotKmerRef> refs_buffer;
+    for(size_t first_bucket = 0; first_bucket < num_buckets; first_bucket += sorted.size()) {
+        size_t num_sorted = std::min(sorted.size(), num_buckets - first_bucket);
+
+        // Reading a bucket can fail, exceptions can't leave a thread so they're rethrown after joining all threads
+        vector<thread> threads;
+        vector<std::exception_ptr> errors(num_sorted);
+        for(size_t i = 0; i < num_sorted; ++i) {
+            threads.emplace_back([&, i] () {
+                try {
+                    buckets[first_bucket + i]->readAll(sorted[i]);
+                    std::sort(sorted[i].begin(), sorted[i].end(), [] (SpillRecord const& a, SpillRecord const& b) {
+                        return a.prefix != b.prefix ? a.prefix < b.prefix : compareWords(a.words, b.words) < 0;
+                    });
+                } catch(...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        for(auto& t : threads) {
+            t.join();
+        }
+
+        for(auto const& error : errors) {
+            if(error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        for(size_t i = 0; i < num_sorted; ++i) {
+            auto const& records = sorted[i];
+            uint64_t start = bucket_start[first_bucket + i];
+
+            words_buffer.resize(records.size() * KMER_WORDS);
+            refs_buffer.resize(records.size());
+            for(size_t j = 0; j < records.size(); ++j) {
+                std::copy(std::begin(records[j].words), std::end(records[j].words), &words_buffer[j * KMER_WORDS]);
+                refs_buffer[j] = records[j].ref;
+                ++index[records[j].prefix + 1];
+            }
+
+            ofile.seekp(header.kmers_offset + start * KMER_WORDS * sizeof(uint64_t));
+            ofile.write(reinterpret_cast<char const*>(words_buffer.data()), words_buffer.size() * sizeof(uint64_t));
+            ofile.seekp(header.refs_offset + start * sizeof(GraphSnapshotKmerRef));
+            ofile.write(reinterpret_cast<char const*>(refs_buffer.data()),
+                        refs_buffer.size() * sizeof(GraphSnapshotKmerRef));
+
+            vector<SpillRecord>().swap(sorted[i]);
+        }
+    }
+
+    for(size_t i = 0; i < num_groups; ++i) {
+        index[i + 1] += index[i];
+    }
+
+    ofile.seekp(header.index_offset);
+    ofile.write(reinterpret_cast<char const*>(index.data()), index.size() * sizeof(uint64_t));
+
+    ofile.seekp(header.color_index_offset);
+    writeSection(ofile, header.color_index_offset, color_index.data(), color_index.size());
+
+    {
+        std::ifstream color_runs_in = color_runs_file.openForReading();
+        for(auto const& block : blocks) {
+            copyRange(color_runs_in, block.color_runs_offset, block.color_runs_size, ofile);
+        }
+    }
+
+    if(!ofile) {
+        throw std::runtime_error("Error while writing " + filepath + ".");
+    }
+}
+
+GraphSnapshot::GraphSnapshot(string const& filepath) :
+    data(nullptr), data_size(0), header(nullptr), unitig_index(nullptr), sequences(nullptr), index(nullptr),
+    kmers(nullptr), refs(nullptr), color_index(nullptr), color_runs(nullptr)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Could not open " + filepath + ".");
+    }
+
+    struct stat file_stat = {};
+    if(fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(GraphSnapshotHeader)) {
+        close(fd);
+        throw std::runtime_error(filepath + " is not a graph snapshot file.");
+    }
+
+    data_size = static_cast<size_t>(file_stat.st_size);
+    data = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED) {
+        data = nullptr;
+        throw std::runtime_error("Could not memory map " + filepath + ".");
+    }
+
+    // Queries jump around in the file, don't let the kernel read ahead
+    madvise(data, data_size, MADV_RANDOM);
+
+    header = static_cast<GraphSnapshotHeader const*>(data);
+    auto invalid = [&] (string const& reason) {
+        munmap(data, data_size);
+        data = nullptr;
+
+        return std::runtime_error(filepath + ": " + reason);
+    };
+
+    if(!std::equal(std::begin(GraphSnapshotHeader::MAGIC), std::end(GraphSnapshotHeader::MAGIC), header->magic)) {
+        throw invalid("not a graph snapshot file.");
+    }
+
+    if(header->version != GraphSnapshotHeader::VERSION) {
+        throw invalid("unsupported file version " + std::to_string(header->version) + ".");
+    }
+
+    if(header->kmer_words != KMER_WORDS) {
+        throw invalid("written with a different maximum k-mer size.");
+    }
+
+    if(header->k != Kmer::k) {
+        throw invalid("written with k-mer size " + std::to_string(header->k) + ", but the current k-mer size is "
+                      + std::to_string(Kmer::k) + ". Set the k-mer size with `set_k_g` first.");
+    }
+
+    // Check that each section is aligned and lies within the file, without overflowing on corrupt sizes
+    auto section_fits = [&] (uint64_t offset, uint64_t num_values, size_t value_size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= data_size
+            && num_values <= (data_size - offset) / value_size;
+    };
+
+    bool valid = header->prefix_bits <= MAX_PREFIX_BITS && header->num_unitigs < data_size / sizeof(uint64_t)
+        && header->num_kmers < data_size / sizeof(GraphSnapshotKmerRef)
+        && section_fits(header->names_offset, header->names_size, 1)
+        && section_fits(header->unitig_index_offset, header->num_unitigs + 1, sizeof(uint64_t))
+        && section_fits(header->sequences_offset, header->sequences_size, 1)
+        && section_fits(header->index_offset, (uint64_t(1) << header->prefix_bits) + 1, sizeof(uint64_t))
+        && section_fits(header->kmers_offset, header->num_kmers * KMER_WORDS, sizeof(uint64_t))
+        && section_fits(header->refs_offset, header->num_kmers, sizeof(GraphSnapshotKmerRef))
+        && section_fits(header->color_index_offset, header->num_unitigs + 1, sizeof(uint64_t))
+        && section_fits(header->color_runs_offset, header->num_color_runs, sizeof(GraphSnapshotColorRun));
+
+    if(!valid) {
+        throw invalid("file is corrupt or truncated.");
+    }
+
+    auto base = static_cast<char const*>(data);
+    unitig_index = reinterpret_cast<uint64_t const*>(base + header->unitig_index_offset);
+    sequences = base + header->sequences_offset;
+    index = reinterpret_cast<uint64_t const*>(base + header->index_offset);
+    kmers = reinterpret_cast<uint64_t const*>(base + header->kmers_offset);
+    refs = reinterpret_cast<GraphSnapshotKmerRef const*>(base + header->refs_offset);
+    color_index = reinterpret_cast<uint64_t const*>(base + header->color_index_offset);
+    color_runs = reinterpret_cast<GraphSnapshotColorRun const*>(base + header->color_runs_offset);
+
+    // The other offsets in the index sections are checked when used, so opening doesn't read the whole index
+    uint64_t num_groups = uint64_t(1) << header->prefix_bits;
+    if(index[0] != 0 || index[num_groups] != header->num_kmers || unitig_index[0] != 0
+       || unitig_index[header->num_unitigs] != header->sequences_size || color_index[0] != 0
+       || color_index[header->num_unitigs] != header->num_color_runs) {
+        throw invalid("file is corrupt or truncated.");
+    }
+
+    char const* name = base + header->names_offset;
+    char const* names_end = name + header->names_size;
+    if(header->names_size > 0 && names_end[-1] != '\0') {
+        throw invalid("file is corrupt or truncated.");
+    }
+
+    while(name < names_end) {
+        color_names.emplace_back(name);
+        name += color_names.back().size() + 1;
+    }
+
+    if(color_names.size() != header->num_colors) {
+        throw invalid("file is corrupt or truncated.");
+    }
+}
+
+GraphSnapshot::GraphSnapshot(GraphSnapshot&& o) noexcept :
+    data(o.data), data_size(o.data_size), header(o.header), unitig_index(o.unitig_index), sequences(o.sequences),
+    index(o.index), kmers(o.kmers), refs(o.refs), color_index(o.color_index), color_runs(o.color_runs),
+    color_names(std::move(o.color_names))
+{
+    o.data = nullptr;
+    o.data_size = 0;
+}
+
+GraphSnapshot::~GraphSnapshot()
+{
+    if(data != nullptr) {
+        munmap(data, data_size);
+    }
+}
+
+bool GraphSnapshot::find(Kmer const& qry, SnapshotPosition& result) const
+{
+    Kmer canonical = qry.rep();
+
+    uint64_t words[KMER_WORDS];
+    kmer_to_words(canonical, words);
+
+    uint64_t lo, hi;
+    std::tie(lo, hi) = checkedRange(index, prefixOf(canonical, header->prefix_bits), header->num_kmers);
+
+    while(lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int cmp = compareWords(kmers + mid * KMER_WORDS, words);
+
+        if(cmp == 0) {
+            if(refs[mid].unitig >= header->num_unitigs) {
+                throw std::runtime_error("Graph snapshot is corrupt: invalid unitig of a k-mer.");
+            }
+
+            bool canonical_forward = (refs[mid].position & GraphSnapshotKmerRef::FORWARD_BIT) != 0;
+
+            result.unitig = refs[mid].unitig;
+            result.position = refs[mid].position & ~GraphSnapshotKmerRef::FORWARD_BIT;
+            result.forward = (qry == canonical) == canonical_forward;
+
+            return true;
+        } else if(cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return false;
+}
+
+std::vector<size_t> GraphSnapshot::kmerColors(Kmer const& qry) const
+{
+    vector<size_t> colors;
+
+    SnapshotPosition pos = {};
+    if(!find(qry, pos)) {
+        return colors;
+    }
+
+    uint64_t begin, end;
+    std::tie(begin, end) = checkedRange(color_index, pos.unitig, header->num_color_runs);
+    for(uint64_t i = begin; i < end; ++i) {
+        if(color_runs[i].start <= pos.position && pos.position < color_runs[i].end) {
+            colors.push_back(color_runs[i].color);
+        }
+    }
+
+    return colors;
+}
+
+std::vector<size_t> GraphSnapshot::unitigColors(size_t unitig) const
+{
+    checkUnitig(unitig);
+
+    // Runs are sorted on color
+    uint64_t begin, end;
+    std::tie(begin, end) = checkedRange(color_index, unitig, header->num_color_runs);
+
+    vector<size_t> colors;
+    for(uint64_t i = begin; i < end; ++i) {
+        if(colors.empty() || colors.back() != color_runs[i].color) {
+            colors.push_back(color_runs[i].color);
+        }
+    }
+
+    return colors;
+}
+
+std::string GraphSnapshot::unitigSequence(size_t unitig) const
+{
+    checkUnitig(unitig);
+
+    uint64_t begin, end;
+    std::tie(begin, end) = checkedRange(unitig_index, unitig, header->sequences_size);
+
+    return string(sequences + begin, sequences + end);
+}
+
+void GraphSnapshot::checkUnitig(size_t unitig) const
+{
+    if(unitig >= header->num_unitigs) {
+        throw std::out_of_range("Unitig " + std::to_string(unitig) + " doesn't exist.");
+    }
+}
+
+std::pair<uint64_t, uint64_t> GraphSnapshot::checkedRange(uint64_t const* offsets, size_t i, uint64_t limit) const
+{
+    uint64_t begin = offsets[i];
+    uint64_t end = offsets[i + 1];
+    if(begin > end || end > limit) {
+        throw std::runtime_error("Graph snapshot is corrupt: invalid offset in index.");
+    }
+
+    return {begin, end};
+}
+
+void define_GraphSnapshot(py::module& m) {
+    auto find = [] (GraphSnapshot const& self, Kmer const& kmer) -> py::object {
+        SnapshotPosition pos = {};
+        if(!self.find(kmer, pos)) {
+            return py::none();
+        }
+
+        return py::make_tuple(pos.unitig, pos.position, pos.forward);
+    };
+
+    py::class_<GraphSnapshot>(m, "GraphSnapshot", py::module_local())
+        .def(py::init<string const&>(), py::arg("filepath"),
+             "Open a graph snapshot saved with `dump_snapshot`.")
+
+        .def("find", find, py::arg("kmer"),
+            "Returns a tuple with the unitig index, and the position and strand of `kmer` in that unitig, or None if "
+            "the k-mer is not in the graph.")
+        .def("find", [find] (GraphSnapshot const& self, char const* kmer) {
+            return find(self, Kmer(kmer));
+        }, py::arg("kmer"))
+
+        .def("kmer_colors", &GraphSnapshot::kmerColors, py::arg("kmer"))
+        .def("kmer_colors", [] (GraphSnapshot const& self, char const* kmer) {
+            return self.kmerColors(Kmer(kmer));
+        }, py::arg("kmer"))
+
+        .def("unitig_colors", &GraphSnapshot::unitigColors, py::arg("unitig"))
+        .def("unitig_sequence", &GraphSnapshot::unitigSequence, py::arg("unitig"))
+
+        .def("__contains__", [] (GraphSnapshot const& self, Kmer const& kmer) {
+            SnapshotPosition pos = {};
+            return self.find(kmer, pos);
+        })
+        .def("__contains__", [] (GraphSnapshot const& self, char const* kmer) {
+            SnapshotPosition pos = {};
+            return self.find(Kmer(kmer), pos);
+        })
+        .def("__len__", &GraphSnapshot::getNumKmers)
+
+        .def_property_readonly("k", &GraphSnapshot::getK)
+        .def_property_readonly("g", &GraphSnapshot::getG)
+        .def_property_readonly("num_unitigs", &GraphSnapshot::getNumUnitigs)
+        .def_property_readonly("color_names", [] (GraphSnapshot const& self) {
+            py::list names;
+            for(auto const& name : self.getColorNames()) {
+                names.append(py::str(name));
+            }
+
+            return names;
+        });
+
+    m.def("dump_snapshot", &GraphSnapshot::write, py::arg("g"), py::arg("filepath"), py::arg("num_threads") = 2,
+          py::arg("tmp_dir") = "", py::call_guard<py::gil_scoped_release>(),
+          "Save a graph as binary snapshot, to open with `GraphSnapshot`. K-mers are sorted in buckets spilled to "
+          "`tmp_dir` (defaults to $TMPDIR or /tmp).");
+}
+
+}
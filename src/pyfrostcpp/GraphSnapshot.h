@@ -0,0 +1,185 @@
+/**
+ * Read-only binary snapshot of a colored graph, opened with mmap.
+ *
+ * The file is written with `GraphSnapshot::write()`, and consists of a fixed size header followed by seven sections,
+ * each aligned to 64 bytes:
+ *
+ *  1. The color names, each terminated by a null character.
+ *  2. A unitig index of `num_unitigs + 1` uint64 offsets, unitig `i` is found at [index[i], index[i+1]) in the next
+ *     section.
+ *  3. The sequences of all unitigs, concatenated.
+ *  4. A prefix index of `2^prefix_bits + 1` uint64 offsets. K-mers are grouped on the top `prefix_bits` bits of
+ *     their hash, and k-mers of group `i` are found at positions [index[i], index[i+1]).
+ *  5. All canonical k-mers in the graph, `kmer_words` uint64 words each, sorted on group and then on their packed
+ *     words.
+ *  6. For each k-mer, in the same order, the unitig it belongs to and its position and strand in that unitig.
+ *  7. A color index of `num_unitigs + 1` uint64 offsets into the next section, followed by the color runs of each
+ *     unitig: a color and the range of k-mer positions in the unitig with that color.
+ *
+ * Opening a snapshot only maps it into memory, so unlike loading a graph with `load`, startup doesn't depend on the
+ * size of the graph, and multiple worker processes share its pages through the page cache. The file is written in
+ * native byte order.
+ */
+
+#ifndef PYFROST_GRAPHSNAPSHOT_H
+#define PYFROST_GRAPHSNAPSHOT_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pyfrost {
+
+/**
+ * Header of a graph snapshot file.
+ */
+struct GraphSnapshotHeader {
+    static constexpr char MAGIC[8] = {'P', 'F', 'G', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t k;
+    uint32_t g;
+    uint32_t kmer_words;
+    uint32_t prefix_bits;
+    uint32_t reserved;
+
+    uint64_t num_unitigs;
+    uint64_t num_kmers;
+    uint64_t num_colors;
+    uint64_t num_color_runs;
+    uint64_t names_size;
+    uint64_t sequences_size;
+
+    uint64_t names_offset;
+    uint64_t unitig_index_offset;
+    uint64_t sequences_offset;
+    uint64_t index_offset;
+    uint64_t kmers_offset;
+    uint64_t refs_offset;
+    uint64_t color_index_offset;
+    uint64_t color_runs_offset;
+};
+
+/**
+ * Location of a canonical k-mer in the graph. The highest bit of `position` is set if the canonical k-mer lies on the
+ * forward strand of the unitig.
+ */
+struct GraphSnapshotKmerRef {
+    static constexpr uint32_t FORWARD_BIT = uint32_t(1) << 31;
+
+    uint32_t unitig;
+    uint32_t position;
+};
+
+/**
+ * K-mers at positions [start, end) of a unitig have color `color`.
+ */
+struct GraphSnapshotColorRun {
+    uint32_t color;
+    uint32_t start;
+    uint32_t end;
+};
+
+/**
+ * Location of a query k-mer in the graph.
+ */
+struct SnapshotPosition {
+    size_t unitig;
+    size_t position;
+
+    /// Whether the query k-mer lies on the forward strand of the unitig
+    bool forward;
+};
+
+class GraphSnapshot {
+public:
+    /**
+     * Open a file written by `GraphSnapshot::write()`. The file's k-mer size has to equal the current global k-mer
+     * size.
+     */
+    explicit GraphSnapshot(std::string const& filepath);
+
+    GraphSnapshot(GraphSnapshot const& o) = delete;
+    GraphSnapshot(GraphSnapshot&& o) noexcept;
+    ~GraphSnapshot();
+
+    GraphSnapshot& operator=(GraphSnapshot const& o) = delete;
+
+    /**
+     * Write a snapshot of `graph`, with unitigs divided over `num_threads` threads. The k-mers are spilled to
+     * temporary files in `tmp_dir` (or $TMPDIR if empty) in buckets of consecutive prefix groups, and sorted one
+     * bucket per thread at a time, so only the k-mers of `num_threads` buckets are in memory at once.
+     */
+    static void write(PyfrostCCDBG& graph, std::string const& filepath, size_t num_threads,
+                      std::string const& tmp_dir = "");
+
+    /**
+     * Find the unitig containing `qry`, returns false if the k-mer is not in the graph.
+     */
+    bool find(Kmer const& qry, SnapshotPosition& result) const;
+
+    /**
+     * Colors of the k-mer `qry`, empty if the k-mer is not in the graph.
+     */
+    std::vector<size_t> kmerColors(Kmer const& qry) const;
+
+    /**
+     * Sorted colors of all k-mers in a unitig.
+     */
+    std::vector<size_t> unitigColors(size_t unitig) const;
+
+    std::string unitigSequence(size_t unitig) const;
+
+    std::vector<std::string> const& getColorNames() const {
+        return color_names;
+    }
+
+    size_t getK() const {
+        return header->k;
+    }
+
+    size_t getG() const {
+        return header->g;
+    }
+
+    uint64_t getNumUnitigs() const {
+        return header->num_unitigs;
+    }
+
+    uint64_t getNumKmers() const {
+        return header->num_kmers;
+    }
+
+private:
+    void checkUnitig(size_t unitig) const;
+
+    /**
+     * Range [offsets[i], offsets[i + 1]) from one of the index sections, throws if it's invalid or exceeds `limit`.
+     */
+    std::pair<uint64_t, uint64_t> checkedRange(uint64_t const* offsets, size_t i, uint64_t limit) const;
+
+    void* data;
+    size_t data_size;
+
+    GraphSnapshotHeader const* header;
+    uint64_t const* unitig_index;
+    char const* sequences;
+    uint64_t const* index;
+    uint64_t const* kmers;
+    GraphSnapshotKmerRef const* refs;
+    uint64_t const* color_index;
+    GraphSnapshotColorRun const* color_runs;
+
+    std::vector<std::string> color_names;
+};
+
+void define_GraphSnapshot(py::module& m);
+
+}
+
+#endif //PYFROST_GRAPHSNAPSHOT_H
@@ -189,7 +189,7 @@ void JunctionTreeNodeWithCov::merge(JunctionTreeNode& other)
 
 
 void define_JunctionTreeNode(py::module& m) {
-    auto py_JunctionTreeNode = py::class_<JunctionTreeNode>(m, "JunctionTreeNode")
+    auto py_JunctionTreeNode = py::class_<JunctionTreeNode>(m, "JunctionTreeNode", py::module_local())
         .def("__getitem__", [] (JunctionTreeNode& self, char edge) {
             return self.getChildren().at(edge).get();
         }, py::return_value_policy::reference)
@@ -274,7 +274,7 @@ void define_JunctionTreeNode(py::module& m) {
     py_JunctionTreeNode.attr("__bases__") = py::make_tuple(Mapping).attr("__add__")(py_JunctionTreeNode.attr("__bases__"));
 
     auto py_JunctionTreeNodeWithCov = py::class_<JunctionTreeNodeWithCov, JunctionTreeNode>(
-        m, "JunctionTreeNodeWithCov")
+        m, "JunctionTreeNodeWithCov", py::module_local())
 
         .def("merge", &JunctionTreeNodeWithCov::merge)
 
@@ -1,4 +1,5 @@
 #include "Kmer.h"
+#include "KmerArray.h"
 
 namespace pyfrost {
 
@@ -93,7 +94,7 @@ bool is_kmer_empty(Kmer const& kmer) {
  * dicts, sets etc.
  */
 void define_Kmer(py::module &m) {
-    py::class_<Kmer>(m, "Kmer")
+    py::class_<Kmer>(m, "Kmer", py::module_local())
         // Constructors
         .def(py::init<>())
         .def(py::init<Kmer const&>())
@@ -157,11 +158,14 @@ void define_Kmer(py::module &m) {
      * because we need to keep the string to k-merize in memory while
      * iterating over it.
      */
-    py::class_<Kmerizer>(m, "kmerize_str")
+    py::class_<Kmerizer>(m, "kmerize_str", py::module_local())
         .def(py::init<std::string const&>())
         .def("__iter__", [] (Kmerizer const& self) {
             return py::make_key_iterator<py::return_value_policy::copy>(self.begin(), self.end());
-        }, py::keep_alive<0, 1>());
+        }, py::keep_alive<0, 1>())
+        .def("to_array", [] (Kmerizer const& self, bool canonical) {
+            return KmerArray::fromSequence(self.getSequence(), canonical);
+        }, py::arg("canonical") = false, "Get all k-mers at once as `KmerArray`.");
 
 
     // Last two bits are reserved for k-mer metadata
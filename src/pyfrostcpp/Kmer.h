@@ -6,8 +6,10 @@
 #include <cereal/cereal.hpp>
 
 #include "UnitigDataDict.h"
+#include "Serialize.h"
 
 #include <Kmer.hpp>
+#include <cstring>
 
 // Specialize hashing for Kmer objects (to be used with robin_hood unordered_map)
 namespace std {
@@ -22,23 +24,6 @@ public:
 
 }
 
-// Cereal serialization support
-template<typename Archive>
-std::string save_minimal(Archive& ar, Kmer const& kmer)
-{
-    stringstream bytes;
-    kmer.write(bytes);
-
-    return bytes.str();
-}
-
-template<typename Archive>
-void load_minimal(Archive& ar, Kmer& kmer, std::string const& value)
-{
-    istringstream stream(value);
-    kmer.read(stream);
-}
-
 namespace py = pybind11;
 
 namespace pyfrost {
@@ -70,6 +55,30 @@ Kmer to_kmer(char const* kmer, bool rev_compl=false);
 
 bool is_kmer_empty(Kmer const& kmer);
 
+/**
+ * Number of 64-bit words in Bifrost's 2-bit packed k-mer representation.
+ */
+constexpr size_t KMER_WORDS = sizeof(Kmer) / sizeof(uint64_t);
+static_assert(sizeof(Kmer) % sizeof(uint64_t) == 0, "Unexpected k-mer memory layout");
+
+/**
+ * Copy the packed words of a k-mer to `words`, which should have room for `KMER_WORDS` values. This is the same
+ * representation `Kmer::write` uses.
+ */
+inline void kmer_to_words(Kmer const& kmer, uint64_t* words) {
+    std::memcpy(words, static_cast<void const*>(&kmer), sizeof(Kmer));
+}
+
+/**
+ * Create a k-mer from `KMER_WORDS` packed words, as obtained with `kmer_to_words`.
+ */
+inline Kmer kmer_from_words(uint64_t const* words) {
+    Kmer kmer;
+    std::memcpy(static_cast<void*>(&kmer), words, sizeof(Kmer));
+
+    return kmer;
+}
+
 void define_Kmer(py::module &m);
 
 
@@ -87,6 +96,10 @@ public:
         return {};
     }
 
+    std::string const& getSequence() const {
+        return str;
+    }
+
 private:
     std::string str;
 };
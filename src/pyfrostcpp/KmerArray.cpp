@@ -0,0 +1,292 @@
+#include "KmerArray.h"
+#include "KmerScanner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+using std::vector;
+using std::string;
+
+namespace pyfrost {
+
+KmerArray KmerArray::fromStrings(std::vector<std::string> const& strings)
+{
+    vector<Kmer> kmers;
+    kmers.reserve(strings.size());
+
+    for(auto const& str : strings) {
+        if(str.size() != Kmer::k) {
+            throw std::invalid_argument("Invalid k-mer '" + str + "', expected length " + std::to_string(Kmer::k));
+        }
+
+        kmers.emplace_back(str.c_str());
+    }
+
+    return KmerArray(std::move(kmers));
+}
+
+KmerArray KmerArray::fromWords(uint64_t const* words, size_t num_kmers)
+{
+    vector<Kmer> kmers;
+    kmers.reserve(num_kmers);
+
+    for(size_t i = 0; i < num_kmers; ++i) {
+        kmers.push_back(kmer_from_words(words + i * KMER_WORDS));
+    }
+
+    return KmerArray(std::move(kmers));
+}
+
+KmerArray KmerArray::fromSequence(std::string const& sequence, bool canonical)
+{
+    KmerScanner scanner;
+    scanner.scan(sequence, canonical, false);
+
+    return KmerArray(vector<Kmer>(scanner.getKmers()));
+}
+
+KmerArray KmerArray::twin() const
+{
+    vector<Kmer> result;
+    result.reserve(kmers.size());
+
+    for(auto const& kmer : kmers) {
+        result.push_back(kmer.twin());
+    }
+
+    return KmerArray(std::move(result));
+}
+
+KmerArray KmerArray::rep() const
+{
+    vector<Kmer> result;
+    result.reserve(kmers.size());
+
+    for(auto const& kmer : kmers) {
+        result.push_back(kmer.rep());
+    }
+
+    return KmerArray(std::move(result));
+}
+
+std::vector<uint64_t> KmerArray::hash(uint64_t seed) const
+{
+    vector<uint64_t> hashes;
+    hashes.reserve(kmers.size());
+
+    for(auto const& kmer : kmers) {
+        hashes.push_back(kmer.hash(seed));
+    }
+
+    return hashes;
+}
+
+std::vector<std::string> KmerArray::toStrings() const
+{
+    vector<string> strings;
+    strings.reserve(kmers.size());
+
+    for(auto const& kmer : kmers) {
+        strings.push_back(kmer.toString());
+    }
+
+    return strings;
+}
+
+KmerArray& KmerArray::sort()
+{
+    std::sort(kmers.begin(), kmers.end());
+    return *this;
+}
+
+KmerArray KmerArray::unique() const
+{
+    KmerArray result(*this);
+    result.sort();
+    result.kmers.erase(std::unique(result.kmers.begin(), result.kmers.end()), result.kmers.end());
+
+    return result;
+}
+
+void KmerArray::isin(KmerArray const& other, bool* out) const
+{
+    // Binary search in a sorted copy, cheaper to build than a hash set for a one-off lookup
+    vector<Kmer> sorted(other.kmers);
+    std::sort(sorted.begin(), sorted.end());
+
+    for(size_t i = 0; i < kmers.size(); ++i) {
+        out[i] = std::binary_search(sorted.begin(), sorted.end(), kmers[i]);
+    }
+}
+
+KmerArray kmerizeBatch(std::vector<std::string> const& sequences, bool canonical, size_t num_threads,
+                       std::vector<uint32_t>& seq_indices, std::vector<uint32_t>& positions)
+{
+    // Threads k-merize blocks of consecutive sequences into their own buffers, which are concatenated in order
+    // afterwards, so the output order doesn't depend on the number of threads.
+    struct Block {
+        vector<Kmer> kmers;
+        vector<uint32_t> seq_indices;
+        vector<uint32_t> positions;
+    };
+
+    num_threads = std::max(size_t(1), num_threads);
+    size_t block_size = std::max(size_t(1), sequences.size() / (num_threads * 8));
+    size_t num_blocks = (sequences.size() + block_size - 1) / block_size;
+    vector<Block> blocks(num_blocks);
+
+    std::atomic<size_t> next_block(0);
+    auto kmerize_blocks = [&] () {
+        KmerScanner scanner;
+        for(size_t block_ix = next_block++; block_ix < num_blocks; block_ix = next_block++) {
+            Block& block = blocks[block_ix];
+            size_t end = std::min(sequences.size(), (block_ix + 1) * block_size);
+
+            for(size_t seq_ix = block_ix * block_size; seq_ix < end; ++seq_ix) {
+                size_t num_kmers = scanner.scan(sequences[seq_ix], canonical, false);
+                block.kmers.insert(block.kmers.end(), scanner.getKmers().begin(), scanner.getKmers().end());
+
+                for(size_t i = 0; i < num_kmers; ++i) {
+                    block.seq_indices.push_back(static_cast<uint32_t>(seq_ix));
+                    block.positions.push_back(static_cast<uint32_t>(scanner.position(i)));
+                }
+            }
+        }
+    };
+
+    vector<std::thread> threads;
+    for(size_t i = 1; i < std::min(num_threads, num_blocks); ++i) {
+        threads.emplace_back(kmerize_blocks);
+    }
+
+    kmerize_blocks();
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    size_t total = 0;
+    for(auto const& block : blocks) {
+        total += block.kmers.size();
+    }
+
+    vector<Kmer> kmers;
+    kmers.reserve(total);
+    seq_indices.clear();
+    seq_indices.reserve(total);
+    positions.clear();
+    positions.reserve(total);
+
+    for(auto& block : blocks) {
+        kmers.insert(kmers.end(), block.kmers.begin(), block.kmers.end());
+        seq_indices.insert(seq_indices.end(), block.seq_indices.begin(), block.seq_indices.end());
+        positions.insert(positions.end(), block.positions.begin(), block.positions.end());
+
+        block = Block();
+    }
+
+    return KmerArray(std::move(kmers));
+}
+
+void define_KmerArray(py::module& m) {
+    py::class_<KmerArray>(m, "KmerArray", py::module_local(), py::buffer_protocol(),
+                          "Contiguous array of k-mers, exposed as a (n, KMER_WORDS) uint64 numpy array of packed "
+                          "k-mers through the buffer protocol.")
+        .def(py::init<>())
+        .def(py::init([] (py::array_t<uint64_t, py::array::c_style | py::array::forcecast> const& words) {
+            if(words.ndim() != 2 || static_cast<size_t>(words.shape(1)) != KMER_WORDS) {
+                throw py::value_error("Expected an array of packed k-mers with shape (n, "
+                                      + std::to_string(KMER_WORDS) + ").");
+            }
+
+            return KmerArray::fromWords(words.data(), static_cast<size_t>(words.shape(0)));
+        }), py::arg("words"))
+        .def(py::init([] (vector<Kmer> kmers) {
+            return KmerArray(std::move(kmers));
+        }), py::arg("kmers"))
+
+        .def_static("from_strings", &KmerArray::fromStrings, py::arg("strings"),
+            "Create an array from a list of k-mer strings.")
+        .def_static("from_sequence", &KmerArray::fromSequence, py::arg("sequence"), py::arg("canonical") = false,
+            "All k-mers in a sequence, skipping k-mers with non-ACGT characters.")
+
+        .def_buffer([] (KmerArray& self) {
+            return py::buffer_info(
+                self.data(), sizeof(uint64_t), py::format_descriptor<uint64_t>::format(), 2,
+                {self.size(), KMER_WORDS}, {sizeof(Kmer), sizeof(uint64_t)}
+            );
+        })
+
+        .def("twin", &KmerArray::twin, py::call_guard<py::gil_scoped_release>(),
+            "Reverse complement of each k-mer.")
+        .def("rep", &KmerArray::rep, py::call_guard<py::gil_scoped_release>(),
+            "Canonical k-mer of each k-mer.")
+        .def("hash", [] (KmerArray const& self, uint64_t seed) {
+            vector<uint64_t> hashes;
+            {
+                py::gil_scoped_release release;
+                hashes = self.hash(seed);
+            }
+
+            return as_pyarray(std::move(hashes));
+        }, py::arg("seed") = 0, "Hash of each k-mer as numpy array, equal to `Kmer.hash`.")
+        .def("to_strings", [] (KmerArray const& self) {
+            py::list strings;
+            for(auto const& str : self.toStrings()) {
+                strings.append(py::str(str));
+            }
+
+            return strings;
+        })
+
+        .def("sort", &KmerArray::sort, py::return_value_policy::reference_internal,
+            py::call_guard<py::gil_scoped_release>(), "Sort the k-mers in place.")
+        .def("unique", &KmerArray::unique, py::call_guard<py::gil_scoped_release>(),
+            "Sorted array of the distinct k-mers.")
+        .def("isin", [] (KmerArray const& self, KmerArray const& other) {
+            py::array_t<bool> result(self.size());
+            bool* out = result.mutable_data();
+            {
+                py::gil_scoped_release release;
+                self.isin(other, out);
+            }
+
+            return result;
+        }, py::arg("other"), "Boolean numpy array indicating for each k-mer whether it occurs in `other`.")
+
+        .def("__len__", &KmerArray::size)
+        .def("__getitem__", [] (KmerArray const& self, int64_t index) {
+            if(index < 0) {
+                index += static_cast<int64_t>(self.size());
+            }
+
+            if(index < 0 || static_cast<size_t>(index) >= self.size()) {
+                throw py::index_error("Index is out of range");
+            }
+
+            return self[index];
+        })
+        .def("__iter__", [] (KmerArray const& self) {
+            return py::make_iterator(self.getKmers().begin(), self.getKmers().end());
+        }, py::keep_alive<0, 1>())
+        .def("__repr__", [] (KmerArray const& self) {
+            return "<KmerArray with " + std::to_string(self.size()) + " k-mers>";
+        });
+
+    m.def("kmerize_batch", [] (vector<string> const& seqs, bool canonical, size_t threads) {
+        KmerArray kmers;
+        vector<uint32_t> seq_indices;
+        vector<uint32_t> positions;
+        {
+            py::gil_scoped_release release;
+            kmers = kmerizeBatch(seqs, canonical, threads, seq_indices, positions);
+        }
+
+        return py::make_tuple(std::move(kmers), as_pyarray(std::move(seq_indices)), as_pyarray(std::move(positions)));
+    }, py::arg("seqs"), py::arg("canonical") = false, py::arg("threads") = 2,
+        "K-merize a list of sequences at once. Returns a tuple with a `KmerArray` of all k-mers, and numpy arrays with "
+        "the sequence index and position of each k-mer. K-mers with non-ACGT characters are skipped.");
+}
+
+}
@@ -0,0 +1,93 @@
+/**
+ * Contiguous array of k-mers, for vectorized k-mer operations from Python.
+ *
+ * K-mers are stored in Bifrost's 2-bit packed representation, `KMER_WORDS` 64-bit words per k-mer. Python sees the
+ * array through the buffer protocol as a `(n, KMER_WORDS)` uint64 array, so `numpy.asarray` doesn't copy. Operations
+ * like `twin`, `rep` and `hash` work on the whole array at once, without creating a Python `Kmer` object per k-mer.
+ */
+
+#ifndef PYFROST_KMERARRAY_H
+#define PYFROST_KMERARRAY_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+
+#include <string>
+#include <vector>
+
+namespace pyfrost {
+
+class KmerArray {
+public:
+    KmerArray() = default;
+    explicit KmerArray(std::vector<Kmer>&& _kmers) : kmers(std::move(_kmers)) { }
+
+    /**
+     * Create an array from k-mer strings. Throws if a string doesn't have length k.
+     */
+    static KmerArray fromStrings(std::vector<std::string> const& strings);
+
+    /**
+     * Create an array from `num_kmers` k-mers of `KMER_WORDS` packed words each.
+     */
+    static KmerArray fromWords(uint64_t const* words, size_t num_kmers);
+
+    /**
+     * All k-mers in a sequence, in order of position. K-mers with non-ACGT characters are skipped, as with
+     * `kmerize_str`.
+     */
+    static KmerArray fromSequence(std::string const& sequence, bool canonical=false);
+
+    KmerArray twin() const;
+    KmerArray rep() const;
+    std::vector<uint64_t> hash(uint64_t seed=0) const;
+    std::vector<std::string> toStrings() const;
+
+    /**
+     * Sort the k-mers in place, in the same order as `Kmer.__lt__`.
+     */
+    KmerArray& sort();
+
+    /**
+     * Sorted array of the distinct k-mers.
+     */
+    KmerArray unique() const;
+
+    /**
+     * For each k-mer, whether it occurs in `other`. Writes `size()` values to `out`.
+     */
+    void isin(KmerArray const& other, bool* out) const;
+
+    size_t size() const {
+        return kmers.size();
+    }
+
+    Kmer const& operator[](size_t i) const {
+        return kmers[i];
+    }
+
+    Kmer* data() {
+        return kmers.data();
+    }
+
+    std::vector<Kmer> const& getKmers() const {
+        return kmers;
+    }
+
+private:
+    std::vector<Kmer> kmers;
+};
+
+/**
+ * K-merize many sequences at once, spread over `num_threads` threads. K-mers with non-ACGT characters are skipped, as
+ * with `KmerIterator`. For each k-mer, `seq_indices` gets the index of its sequence and `positions` its position in
+ * that sequence. K-mers are ordered by sequence and then by position.
+ */
+KmerArray kmerizeBatch(std::vector<std::string> const& sequences, bool canonical, size_t num_threads,
+                       std::vector<uint32_t>& seq_indices, std::vector<uint32_t>& positions);
+
+void define_KmerArray(py::module& m);
+
+}
+
+#endif //PYFROST_KMERARRAY_H
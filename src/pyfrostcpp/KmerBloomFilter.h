@@ -0,0 +1,108 @@
+/**
+ * A concurrent, blocked Bloom filter of k-mers.
+ *
+ * All bits of a k-mer are set in a single 512-bit block (one cache line), so a lookup costs one cache miss instead of
+ * one per hash function. Bits are set with an atomic fetch-or, so multiple threads can insert at the same time.
+ *
+ * Putze, Felix, et al. "Cache-, hash-and space-efficient bloom filters." WEA 2007.
+ */
+
+#ifndef PYFROST_KMERBLOOMFILTER_H
+#define PYFROST_KMERBLOOMFILTER_H
+
+#include "Kmer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+namespace pyfrost {
+
+class KmerBloomFilter {
+public:
+    static constexpr size_t NUM_HASHES = 3;
+
+    /**
+     * @param size_bits Log2 of the number of bits in the filter, at least 9 (a single block)
+     */
+    explicit KmerBloomFilter(size_t size_bits) :
+        num_blocks(size_t(1) << (std::max(size_t(BLOCK_BITS), size_bits) - BLOCK_BITS)),
+        words(std::make_unique<std::atomic<uint64_t>[]>(num_blocks * WORDS_PER_BLOCK))
+    {
+        clear();
+    }
+
+    KmerBloomFilter(KmerBloomFilter const& o) :
+        num_blocks(o.num_blocks), words(std::make_unique<std::atomic<uint64_t>[]>(num_blocks * WORDS_PER_BLOCK))
+    {
+        for(size_t i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i) {
+            words[i].store(o.words[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Add a k-mer to the filter.
+     *
+     * @return true if the k-mer was (probably) inserted before, false if this is certainly its first insertion
+     */
+    bool testAndSet(Kmer const& kmer) {
+        uint64_t h1 = kmer.hash(0x8CB92BA72F3D8DD7ULL);
+        uint64_t h2 = kmer.hash(0xE7037ED1A0B428DBULL);
+
+        // Pick the block with the high bits of the first hash, and the bits within the block from the second
+        auto block = static_cast<size_t>((static_cast<unsigned __int128>(h1) * num_blocks) >> 64);
+        std::atomic<uint64_t>* block_words = &words[block * WORDS_PER_BLOCK];
+
+        bool present = true;
+        for(size_t i = 0; i < NUM_HASHES; ++i) {
+            size_t bit = (h2 >> (i * BLOCK_BITS)) & ((size_t(1) << BLOCK_BITS) - 1);
+            uint64_t mask = uint64_t(1) << (bit % 64);
+
+            if(!(block_words[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask)) {
+                present = false;
+            }
+        }
+
+        return present;
+    }
+
+    /**
+     * Estimate the number of distinct k-mers inserted from the fraction of set bits.
+     *
+     * Swamidass, S. Joshua, and Pierre Baldi. "Mathematical correction for fingerprint similarity measures to improve
+     * chemical retrieval." Journal of chemical information and modeling 47.3 (2007).
+     */
+    uint64_t estimateSize() const {
+        uint64_t num_set = 0;
+        for(size_t i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i) {
+            num_set += __builtin_popcountll(words[i].load(std::memory_order_relaxed));
+        }
+
+        auto num_bits = static_cast<double>(num_blocks * WORDS_PER_BLOCK * 64);
+        if(num_set >= num_bits) {
+            return static_cast<uint64_t>(num_bits);
+        }
+
+        double fill = num_set / num_bits;
+        return static_cast<uint64_t>(std::llround(-num_bits / NUM_HASHES * std::log1p(-fill)));
+    }
+
+    void clear() {
+        for(size_t i = 0; i < num_blocks * WORDS_PER_BLOCK; ++i) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr size_t BLOCK_BITS = 9;
+    static constexpr size_t WORDS_PER_BLOCK = (size_t(1) << BLOCK_BITS) / 64;
+
+    size_t num_blocks;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+};
+
+}
+
+#endif //PYFROST_KMERBLOOMFILTER_H
@@ -0,0 +1,657 @@
+/**
+ * A concurrent open addressing hash table mapping k-mers to counts.
+ *
+ * Slots are claimed with a compare-and-swap on a per-slot state byte, and counts are incremented with a
+ * (saturating) compare-and-swap loop, so multiple counter threads can insert into the same table without taking a
+ * mutex per k-mer. The only time a thread has to wait for others is when the table grows: inserting threads hold a
+ * shared lock on the table, and the thread that pushes the table over its maximum load factor takes the exclusive
+ * lock to rehash.
+ *
+ * The width of the per-slot counter is a template parameter. Tables with 8-bit counters keep counts that don't fit in
+ * a slot in a small side table, see `KmerCountTraits`.
+ */
+
+#ifndef PYFROST_KMERCOUNTTABLE_H
+#define PYFROST_KMERCOUNTTABLE_H
+
+#include "Kmer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <robin_hood.h>
+
+namespace pyfrost {
+
+/**
+ * Describes the counts reported by a `KmerCountTable` with a given per-slot storage type.
+ *
+ * Most k-mers in a read set have low counts, so 8-bit slots suffice for the vast majority of entries. Those tables
+ * store counts of 255 and higher in an overflow table, and report 32-bit counts. Wider slots saturate at the maximum
+ * value of the slot type.
+ */
+template<typename T>
+struct KmerCountTraits {
+    using count_type = T;
+    static constexpr bool has_overflow = false;
+};
+
+template<>
+struct KmerCountTraits<uint8_t> {
+    using count_type = uint32_t;
+    static constexpr bool has_overflow = true;
+};
+
+template<typename T>
+class KmerCountTable {
+public:
+    using storage_type = T;
+    using count_type = typename KmerCountTraits<T>::count_type;
+    using value_type = std::pair<Kmer, count_type>;
+
+    static constexpr count_type MAX_COUNT = std::numeric_limits<count_type>::max();
+
+    explicit KmerCountTable(size_t initial_capacity = 16) :
+        capacity(roundCapacity(initial_capacity)), num_entries(0),
+        resize_lock(std::make_unique<std::shared_timed_mutex>()), overflow(makeOverflow())
+    {
+        allocate(capacity);
+    }
+
+    KmerCountTable(KmerCountTable const& o) :
+        capacity(o.capacity), num_entries(o.num_entries.load()),
+        resize_lock(std::make_unique<std::shared_timed_mutex>()), overflow(makeOverflow())
+    {
+        allocate(capacity);
+        for(size_t i = 0; i < capacity; ++i) {
+            states[i].store(o.states[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            keys[i] = o.keys[i];
+            counts[i].store(o.counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        if(overflow && o.overflow) {
+            overflow->counts = o.overflow->counts;
+        }
+    }
+
+    KmerCountTable(KmerCountTable&& o) noexcept :
+        capacity(o.capacity), num_entries(o.num_entries.load()), keys(std::move(o.keys)), states(std::move(o.states)),
+        counts(std::move(o.counts)), resize_lock(std::move(o.resize_lock)), overflow(std::move(o.overflow))
+    {
+        o.capacity = 0;
+        o.num_entries = 0;
+    }
+
+    KmerCountTable& operator=(KmerCountTable const& o) {
+        if(this != &o) {
+            KmerCountTable tmp(o);
+            *this = std::move(tmp);
+        }
+
+        return *this;
+    }
+
+    KmerCountTable& operator=(KmerCountTable&& o) noexcept {
+        capacity = o.capacity;
+        num_entries = o.num_entries.load();
+        keys = std::move(o.keys);
+        states = std::move(o.states);
+        counts = std::move(o.counts);
+        resize_lock = std::move(o.resize_lock);
+        overflow = std::move(o.overflow);
+
+        o.capacity = 0;
+        o.num_entries = 0;
+
+        return *this;
+    }
+
+    /**
+     * Add `amount` to the count of the given k-mer, inserting it if it doesn't exist yet. Counts saturate at
+     * `MAX_COUNT`. Safe to call concurrently from multiple threads.
+     *
+     * @return pair with the new count of the k-mer and whether the k-mer was newly inserted
+     */
+    std::pair<count_type, bool> increment(Kmer const& kmer, count_type amount = 1) {
+        return increment(kmer, amount, [] (count_type, count_type) { });
+    }
+
+    /**
+     * Like `increment(kmer, amount)`, and calls `on_update(old_count, new_count)` if the count changed.
+     */
+    template<typename F>
+    std::pair<count_type, bool> increment(Kmer const& kmer, count_type amount, F&& on_update) {
+        while(true) {
+            size_t curr_capacity;
+            {
+                std::shared_lock<std::shared_timed_mutex> guard(*resize_lock);
+                curr_capacity = capacity;
+
+                size_t slot;
+                bool inserted;
+                if(claimSlot(kmer, slot, inserted)) {
+                    count_type previous;
+                    count_type new_count = addSaturating(slot, kmer, amount, previous);
+                    size_t entries = inserted ? num_entries.fetch_add(1, std::memory_order_relaxed) + 1 : 0;
+
+                    guard.unlock();
+
+                    if(new_count != previous) {
+                        on_update(previous, new_count);
+                    }
+
+                    if(inserted && entries > maxEntries(curr_capacity)) {
+                        grow(curr_capacity);
+                    }
+
+                    return {new_count, inserted};
+                }
+            }
+
+            // No free slot left, grow the table and try again
+            grow(curr_capacity);
+        }
+    }
+
+    /**
+     * Increment the count of each k-mer in the range [first, last) by one, taking the shared table lock only once for
+     * the whole batch (unless the table needs to grow halfway). Safe to call concurrently from multiple threads.
+     *
+     * @return pair with the number of newly inserted k-mers and the highest count seen among the batch
+     */
+    template<typename Iter>
+    std::pair<size_t, count_type> incrementBatch(Iter first, Iter last) {
+        return incrementBatch(first, last, [] (count_type, count_type) { });
+    }
+
+    /**
+     * Like `incrementBatch(first, last)`, and calls `on_update(old_count, new_count)` for each k-mer whose count
+     * changed.
+     */
+    template<typename Iter, typename F>
+    std::pair<size_t, count_type> incrementBatch(Iter first, Iter last, F&& on_update) {
+        size_t num_inserted = 0;
+        count_type batch_max = 0;
+
+        while(first != last) {
+            std::shared_lock<std::shared_timed_mutex> guard(*resize_lock);
+            size_t curr_capacity = capacity;
+            bool needs_growth = false;
+
+            for(; first != last && !needs_growth; ++first) {
+                size_t slot;
+                bool inserted;
+                if(!claimSlot(*first, slot, inserted)) {
+                    needs_growth = true;
+                    break;
+                }
+
+                count_type previous;
+                count_type new_count = addSaturating(slot, *first, 1, previous);
+                if(new_count != previous) {
+                    on_update(previous, new_count);
+                }
+
+                batch_max = std::max(batch_max, new_count);
+                if(inserted) {
+                    ++num_inserted;
+                    needs_growth = num_entries.fetch_add(1, std::memory_order_relaxed) + 1 > maxEntries(curr_capacity);
+                }
+            }
+
+            guard.unlock();
+
+            if(needs_growth) {
+                grow(curr_capacity);
+            }
+        }
+
+        return {num_inserted, batch_max};
+    }
+
+    /**
+     * Add all counts of `other` to this table, saturating at `MAX_COUNT`. Not safe to call concurrently with other
+     * writers.
+     *
+     * @return pair with the number of newly inserted k-mers and the highest resulting count among the merged k-mers
+     */
+    std::pair<size_t, count_type> merge(KmerCountTable const& other) {
+        return merge(other, [] (count_type, count_type) { });
+    }
+
+    /**
+     * Like `merge(other)`, and calls `on_update(old_count, new_count)` for each k-mer whose count changed.
+     */
+    template<typename F>
+    std::pair<size_t, count_type> merge(KmerCountTable const& other, F&& on_update) {
+        // Grow once up front, tables of different samples usually share most of their k-mers
+        reserve(std::max(size(), other.size()));
+
+        size_t num_inserted = 0;
+        count_type merged_max = 0;
+        for(auto const& e : other) {
+            count_type new_count;
+            bool inserted;
+            std::tie(new_count, inserted) = increment(e.first, e.second, on_update);
+
+            num_inserted += inserted;
+            merged_max = std::max(merged_max, new_count);
+        }
+
+        return {num_inserted, merged_max};
+    }
+
+    /**
+     * Get the count of a k-mer, or zero if the k-mer is not present. Not safe to call concurrently with `increment`.
+     */
+    count_type find(Kmer const& kmer) const {
+        if(capacity == 0) {
+            return 0;
+        }
+
+        size_t mask = capacity - 1;
+        for(size_t i = kmer.hash() & mask, probed = 0; probed < capacity; i = (i + 1) & mask, ++probed) {
+            uint8_t state = states[i].load(std::memory_order_acquire);
+            if(state == EMPTY) {
+                return 0;
+            }
+
+            if(keys[i] == kmer) {
+                return countAt(i);
+            }
+        }
+
+        return 0;
+    }
+
+    bool contains(Kmer const& kmer) const {
+        return find(kmer) > 0;
+    }
+
+    size_t size() const {
+        return num_entries.load();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    void clear() {
+        capacity = roundCapacity(16);
+        num_entries = 0;
+        allocate(capacity);
+        overflow = makeOverflow();
+    }
+
+    /**
+     * Number of entries with a count too large to store in their slot, kept in the overflow table.
+     */
+    size_t overflowSize() const {
+        return overflow ? overflow->counts.size() : 0;
+    }
+
+    /**
+     * Make sure the table can hold at least `n` entries without growing. Not thread safe.
+     */
+    void reserve(size_t n) {
+        size_t new_capacity = capacity;
+        while(maxEntries(new_capacity) < n) {
+            new_capacity *= 2;
+        }
+
+        if(new_capacity != capacity) {
+            rehash(new_capacity);
+        }
+    }
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = KmerCountTable::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type const&;
+        using pointer = value_type const*;
+
+        const_iterator(KmerCountTable const* _table, size_t _slot) : table(_table), slot(_slot) {
+            skipEmpty();
+        }
+
+        const_iterator(const_iterator const& o) = default;
+        const_iterator& operator=(const_iterator const& o) = default;
+
+        const_iterator& operator++() {
+            ++slot;
+            skipEmpty();
+
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator tmp(*this);
+            operator++();
+
+            return tmp;
+        }
+
+        reference operator*() const {
+            return current;
+        }
+
+        pointer operator->() const {
+            return &current;
+        }
+
+        bool operator==(const_iterator const& o) const {
+            return table == o.table && slot == o.slot;
+        }
+
+        bool operator!=(const_iterator const& o) const {
+            return !operator==(o);
+        }
+
+    private:
+        void skipEmpty() {
+            if(table == nullptr) {
+                return;
+            }
+
+            while(slot < table->capacity && table->states[slot].load(std::memory_order_relaxed) != FULL) {
+                ++slot;
+            }
+
+            if(slot < table->capacity) {
+                current = {table->keys[slot], table->countAt(slot)};
+            }
+        }
+
+        KmerCountTable const* table;
+        size_t slot;
+        value_type current;
+    };
+
+    const_iterator begin() const {
+        return {this, 0};
+    }
+
+    const_iterator end() const {
+        return {this, capacity};
+    }
+
+    // Cereal serialization. K-mers and counts are written as two contiguous blocks, after the k-mer format tag and
+    // the width of the count slots. Tables saved in the legacy format, with the layout of our robin_hood::unordered_map
+    // serialization in Serialize.h and 16-bit counts, can still be loaded, see `loadTable`.
+    template<typename Archive>
+    void save(Archive& ar) const {
+        std::vector<Kmer> kmers;
+        std::vector<count_type> counts;
+        kmers.reserve(size());
+        counts.reserve(size());
+
+        for(auto const& e : *this) {
+            kmers.push_back(e.first);
+            counts.push_back(e.second);
+        }
+
+        save_kmer_format(ar);
+        ar(static_cast<uint32_t>(sizeof(T)));
+        ar(cereal::make_size_tag(static_cast<cereal::size_type>(kmers.size())));
+        ar(cereal::binary_data(kmers.data(), kmers.size() * sizeof(Kmer)));
+        ar(counts);
+    }
+
+    template<typename Archive>
+    void load(Archive& ar) {
+        loadTable(ar);
+    }
+
+    /**
+     * Load a table written by `save` or by older versions, returns whether the table was in the legacy format.
+     */
+    template<typename Archive>
+    bool loadTable(Archive& ar) {
+        uint64_t legacy_size = 0;
+        bool legacy = load_kmer_format(ar, legacy_size);
+
+        std::vector<Kmer> kmers;
+        std::vector<count_type> counts;
+        if(legacy) {
+            kmers.resize(legacy_size);
+            counts.resize(legacy_size);
+
+            for(size_t i = 0; i < legacy_size; ++i) {
+                LegacyCount count;
+                ar(LegacyKmer {kmers[i]});
+                ar(count);
+
+                counts[i] = count;
+            }
+        } else {
+            uint32_t width;
+            ar(width);
+            check_count_width<T>(width);
+
+            cereal::size_type n;
+            ar(cereal::make_size_tag(n));
+            kmers.resize(n);
+            ar(cereal::binary_data(kmers.data(), kmers.size() * sizeof(Kmer)));
+            ar(counts);
+
+            if(counts.size() != kmers.size()) {
+                throw std::runtime_error("Corrupt k-mer count table: number of k-mers and counts differ.");
+            }
+        }
+
+        capacity = roundCapacity(16);
+        num_entries = 0;
+        while(maxEntries(capacity) < kmers.size()) {
+            capacity *= 2;
+        }
+
+        allocate(capacity);
+        overflow = makeOverflow();
+
+        for(size_t i = 0; i < kmers.size(); ++i) {
+            increment(kmers[i], counts[i]);
+        }
+
+        return legacy;
+    }
+
+private:
+    enum : uint8_t {
+        EMPTY = 0,
+        BUSY = 1,
+        FULL = 2
+    };
+
+    static constexpr T MAX_STORED = std::numeric_limits<T>::max();
+
+    struct Overflow {
+        std::mutex lock;
+        robin_hood::unordered_map<Kmer, count_type> counts;
+    };
+
+    static std::unique_ptr<Overflow> makeOverflow() {
+        return KmerCountTraits<T>::has_overflow ? std::make_unique<Overflow>() : nullptr;
+    }
+
+    static size_t roundCapacity(size_t n) {
+        size_t c = 16;
+        while(c < n) {
+            c *= 2;
+        }
+
+        return c;
+    }
+
+    static size_t maxEntries(size_t cap) {
+        // Max load factor of 0.75
+        return cap - cap / 4;
+    }
+
+    void allocate(size_t cap) {
+        keys = std::make_unique<Kmer[]>(cap);
+        states = std::make_unique<std::atomic<uint8_t>[]>(cap);
+        counts = std::make_unique<std::atomic<T>[]>(cap);
+
+        for(size_t i = 0; i < cap; ++i) {
+            states[i].store(EMPTY, std::memory_order_relaxed);
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Find the slot for the given k-mer, claiming an empty slot if the k-mer is not present yet. Caller must hold
+     * the shared lock.
+     *
+     * @return false if the table has no free slots left
+     */
+    bool claimSlot(Kmer const& kmer, size_t& slot, bool& inserted) {
+        size_t mask = capacity - 1;
+        for(size_t i = kmer.hash() & mask, probed = 0; probed < capacity; i = (i + 1) & mask, ++probed) {
+            uint8_t state = states[i].load(std::memory_order_acquire);
+
+            if(state == EMPTY) {
+                if(states[i].compare_exchange_strong(state, BUSY, std::memory_order_acq_rel)) {
+                    keys[i] = kmer;
+                    states[i].store(FULL, std::memory_order_release);
+
+                    slot = i;
+                    inserted = true;
+                    return true;
+                }
+            }
+
+            // Another thread is writing the key to this slot, wait until it's published
+            while(state == BUSY) {
+                std::this_thread::yield();
+                state = states[i].load(std::memory_order_acquire);
+            }
+
+            if(keys[i] == kmer) {
+                slot = i;
+                inserted = false;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    count_type countAt(size_t slot) const {
+        T stored = counts[slot].load(std::memory_order_relaxed);
+        if(!KmerCountTraits<T>::has_overflow || stored < MAX_STORED) {
+            return stored;
+        }
+
+        // Overflow table holds the part of the count that doesn't fit in the slot
+        auto it = overflow->counts.find(keys[slot]);
+        return MAX_STORED + (it != overflow->counts.end() ? it->second : 0);
+    }
+
+    /**
+     * Add `amount` to the count in `slot`, saturating at `MAX_COUNT`. The count before the addition is stored in
+     * `previous`. Each update changes the count atomically, so concurrent updates of the same k-mer report a
+     * consistent chain of previous and new counts.
+     */
+    count_type addSaturating(size_t slot, Kmer const& kmer, count_type amount, count_type& previous) {
+        T curr = counts[slot].load(std::memory_order_relaxed);
+
+        while(true) {
+            uint64_t sum = static_cast<uint64_t>(curr) + amount;
+            if(KmerCountTraits<T>::has_overflow && sum >= MAX_STORED) {
+                break;
+            }
+
+            T next = sum > MAX_STORED ? MAX_STORED : static_cast<T>(sum);
+            if(next == curr || counts[slot].compare_exchange_weak(curr, next, std::memory_order_relaxed)) {
+                previous = curr;
+                return next;
+            }
+        }
+
+        // The count doesn't fit in the slot. Updates that reach the overflow table saturate the slot and update the
+        // overflow table under a single lock, this is rare enough that a single lock for the whole table is fine.
+        std::lock_guard<std::mutex> guard(overflow->lock);
+
+        // Threads that don't reach the overflow table may have incremented the slot since, exchanging includes their
+        // additions. Once the slot is saturated, all updates of this k-mer go through the lock.
+        curr = counts[slot].exchange(MAX_STORED, std::memory_order_relaxed);
+
+        auto it = overflow->counts.find(kmer);
+        previous = curr + (it != overflow->counts.end() ? it->second : 0);
+
+        uint64_t total = std::min<uint64_t>(static_cast<uint64_t>(previous) + amount, MAX_COUNT);
+        if(total > MAX_STORED) {
+            overflow->counts[kmer] = static_cast<count_type>(total - MAX_STORED);
+        }
+
+        return static_cast<count_type>(total);
+    }
+
+    void grow(size_t seen_capacity) {
+        std::unique_lock<std::shared_timed_mutex> guard(*resize_lock);
+
+        // Another thread may have grown the table already
+        if(capacity != seen_capacity) {
+            return;
+        }
+
+        rehash(capacity * 2);
+    }
+
+    void rehash(size_t new_capacity) {
+        auto old_keys = std::move(keys);
+        auto old_states = std::move(states);
+        auto old_counts = std::move(counts);
+        size_t old_capacity = capacity;
+
+        capacity = new_capacity;
+        allocate(capacity);
+
+        size_t mask = capacity - 1;
+        for(size_t i = 0; i < old_capacity; ++i) {
+            if(old_states[i].load(std::memory_order_relaxed) != FULL) {
+                continue;
+            }
+
+            size_t j = old_keys[i].hash() & mask;
+            while(states[j].load(std::memory_order_relaxed) != EMPTY) {
+                j = (j + 1) & mask;
+            }
+
+            keys[j] = old_keys[i];
+            states[j].store(FULL, std::memory_order_relaxed);
+            counts[j].store(old_counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity;
+    std::atomic<size_t> num_entries;
+
+    std::unique_ptr<Kmer[]> keys;
+    std::unique_ptr<std::atomic<uint8_t>[]> states;
+    std::unique_ptr<std::atomic<T>[]> counts;
+
+    std::unique_ptr<std::shared_timed_mutex> resize_lock;
+    std::unique_ptr<Overflow> overflow;
+};
+
+template<typename T>
+constexpr typename KmerCountTable<T>::count_type KmerCountTable<T>::MAX_COUNT;
+
+template<typename T>
+constexpr T KmerCountTable<T>::MAX_STORED;
+
+}
+
+#endif //PYFROST_KMERCOUNTTABLE_H
@@ -1,6 +1,13 @@
 #include "KmerCounter.h"
 
+#include <algorithm>
+#include <cstring>
 #include <thread>
+#include <future>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <unistd.h>
 #include <cereal/archives/binary.hpp>
 
 using std::vector;
@@ -13,256 +20,1216 @@ using std::mutex;
 
 namespace pyfrost {
 
-KmerCounter::KmerCounter(size_t _k, size_t _g, bool _canonical, size_t _num_threads, size_t _table_bits,
-    size_t _batch_size) :
-    k(_k), g(_g), canonical(_canonical), num_threads(_num_threads), batch_size(_batch_size),
-    tables(1 << _table_bits), table_locks(1 << _table_bits),
-    num_kmers(0), num_unique(0), max_count(0), finished_reading(false)
+template<typename T>
+KmerCounter<T>::KmerCounter(size_t _k, size_t _g, bool _canonical, size_t _num_threads, size_t _table_bits,
+    size_t _batch_size, bool _superkmers, size_t _num_readers, size_t _singleton_filter_bits) :
+    k(_k), g(_g), canonical(_canonical), num_threads(_num_threads), batch_size(_batch_size), superkmers(_superkmers),
+    num_readers(std::max(size_t(1), _num_readers)),
+    singleton_filter(_singleton_filter_bits > 0 ? std::make_unique<KmerBloomFilter>(_singleton_filter_bits) : nullptr),
+    tables(1 << _table_bits),
+    num_kmers(0), num_unique(0), max_count(0), pipeline(num_threads, batch_size, num_readers)
 {
     setKG(k, g);
 }
 
-KmerCounter::KmerCounter(KmerCounter const& o) :
+template<typename T>
+KmerCounter<T>::KmerCounter(KmerCounter const& o) :
     k(o.k), g(o.g), canonical(o.canonical), num_threads(o.num_threads), batch_size(o.batch_size),
-    tables(o.tables), table_locks(tables.size()), num_kmers(o.num_kmers.load()), num_unique(o.num_unique.load()),
-    max_count(o.max_count.load()), finished_reading(o.finished_reading.load())
+    superkmers(o.superkmers), num_readers(o.num_readers),
+    singleton_filter(o.singleton_filter ? std::make_unique<KmerBloomFilter>(*o.singleton_filter) : nullptr),
+    tables(o.tables), num_kmers(o.num_kmers.load()),
+    num_unique(o.num_unique.load()), max_count(o.max_count.load()), spectrum(o.spectrum),
+    pipeline(num_threads, batch_size, num_readers)
 {
     setKG(k, g);
 }
 
-KmerCounter::KmerCounter(KmerCounter&& o) :
+template<typename T>
+KmerCounter<T>::KmerCounter(KmerCounter&& o) :
     k(o.k), g(o.g), canonical(o.canonical), num_threads(o.num_threads), batch_size(o.batch_size),
-    tables(std::move(o.tables)), table_locks(tables.size()), num_kmers(o.num_kmers.load()),
-    num_unique(o.num_unique.load()), max_count(o.max_count.load()), finished_reading(o.finished_reading.load())
+    superkmers(o.superkmers), num_readers(o.num_readers), singleton_filter(std::move(o.singleton_filter)),
+    tables(std::move(o.tables)), num_kmers(o.num_kmers.load()),
+    num_unique(o.num_unique.load()), max_count(o.max_count.load()), spectrum(std::move(o.spectrum)),
+    pipeline(num_threads, batch_size, num_readers)
 {
     setKG(k, g);
 }
 
-KmerCounter& KmerCounter::countKmers(std::string const& str)
+template<typename T>
+KmerCounter<T>::~KmerCounter()
 {
-    unique_lock<mutex> guard(queue_lock);
-    auto sequences = make_unique<vector<string>>();
-    sequences->emplace_back(str);
-    seq_queue.emplace(std::move(sequences));
-    guard.unlock();
-    finished_reading = true;
+    if(isStreaming()) {
+        finish();
+    }
+}
 
-    thread counter_thread(&KmerCounter::counterThread, this);
-    sequence_ready.notify_one();
+template<typename T>
+KmerCounter<T>& KmerCounter<T>::countKmers(std::string const& str)
+{
+    if(isStreaming()) {
+        feed(vector<string> {str});
+        return *this;
+    }
 
-    counter_thread.join();
+    CounterThreadStats stats;
+    countRead(str, stats);
+    mergeThreadStats(stats);
 
     return *this;
 }
 
-KmerCounter& KmerCounter::countKmersFiles(std::vector<std::string> const& files)
+template<typename T>
+void KmerCounter<T>::start()
 {
-    vector<thread> counter_threads;
-    finished_reading = false;
+    pipeline.start([this] () { counterThread(); });
+}
+
+template<typename T>
+void KmerCounter<T>::feed(std::vector<std::string>&& batch)
+{
+    pipeline.feed(std::move(batch));
+}
+
+template<typename T>
+KmerCounter<T>& KmerCounter<T>::finish()
+{
+    pipeline.finish();
+    return *this;
+}
+
+template<typename T>
+KmerCounter<T>& KmerCounter<T>::countKmersFiles(std::vector<std::string> const& files)
+{
+    pipeline.run(files, [this] () { counterThread(); });
+    return *this;
+}
+
+template<typename T>
+void KmerCounter<T>::counterThread()
+{
+    // Keep statistics local to this thread, and only merge them with the shared counters at the end. Bumping shared
+    // atomics for every k-mer causes a lot of cache line contention between threads.
+    CounterThreadStats stats;
+
+    pipeline.processQueue([&] (string const& sequence) {
+        countRead(sequence, stats);
+    });
+
+    mergeThreadStats(stats);
+}
 
-    for(int i = 0; i < num_threads; ++i) {
-        counter_threads.emplace_back(&KmerCounter::counterThread, this);
+template<typename T>
+void KmerCounter<T>::countRead(std::string const& sequence, CounterThreadStats& stats)
+{
+    if(superkmers) {
+        countSuperKmers(sequence, stats);
+    } else {
+        countSequence(sequence, stats);
     }
+}
 
-    std::thread reader_thread([&] () {
-        FileParser fp(files);
+template<typename T>
+void KmerCounter<T>::countSequence(std::string const& sequence, CounterThreadStats& stats)
+{
+    thread_local KmerScanner scanner;
+    size_t num_scanned = scanner.scan(sequence, canonical, true);
 
-        auto sequences = make_unique<vector<string>>();
-        sequences->reserve(batch_size);
+    auto update_spectrum = [&stats] (count_type old_count, count_type new_count) {
+        stats.spectrum.update(old_count, new_count);
+    };
 
-        string sequence;
-        size_t file_ix = 0;
-        size_t num_read = 0;
-        while(fp.read(sequence, file_ix)) {
-            ++num_read;
-            sequences->emplace_back(sequence);
+    for(size_t i = 0; i < num_scanned; ++i) {
+        Kmer const& kmer = scanner.kmer(i);
+        ++stats.num_kmers;
 
-            if(num_read >= batch_size) {
-                // When enough data read, push sequences on the queue. This way we don't have to lock the queue that
-                // often.
-                unique_lock<mutex> guard(queue_lock);
-                seq_queue.emplace(std::move(sequences));
-                guard.unlock();
+        // Minimizer hash serves as hash table index
+        size_t table_ix = scanner.minimizerHash(i) % tables.size();
 
-                sequences = make_unique<vector<string>>();
-                sequences->reserve(batch_size);
-                num_read = 0;
-                sequence_ready.notify_one();
-            }
+        if(singleton_filter) {
+            countFiltered(kmer, table_ix, stats);
+            continue;
         }
 
-        // Push remaining sequences on the queue
-        if(!sequences->empty()) {
-            unique_lock<mutex> guard(queue_lock);
-            seq_queue.emplace(std::move(sequences));
-            guard.unlock();
+        count_type curr_count;
+        bool inserted;
+        std::tie(curr_count, inserted) = tables[table_ix].increment(kmer, 1, update_spectrum);
 
-            sequence_ready.notify_one();
+        if(inserted) {
+            ++stats.num_unique;
         }
 
-        finished_reading = true;
-        sequence_ready.notify_all();
+        stats.max_count = std::max<uint64_t>(stats.max_count, curr_count);
+    }
+}
+
+/**
+ * Count k-mers by super-k-mer. The whole run is inserted as a single batch, so we only hit the table lock and look up
+ * the partition once per run instead of once per k-mer.
+ */
+template<typename T>
+void KmerCounter<T>::countSuperKmers(std::string const& sequence, CounterThreadStats& stats)
+{
+    forEachSuperKmer(sequence, tables.size(), canonical, [&] (size_t table_ix, KmerRun const& run, int) {
+        stats.num_kmers += run.size();
+
+        if(singleton_filter) {
+            for(auto const& kmer : run) {
+                countFiltered(kmer, table_ix, stats);
+            }
+
+            return;
+        }
+
+        size_t num_inserted;
+        count_type run_max;
+        std::tie(num_inserted, run_max) = tables[table_ix].incrementBatch(run.begin(), run.end(),
+            [&stats] (count_type old_count, count_type new_count) { stats.spectrum.update(old_count, new_count); });
+
+        stats.num_unique += num_inserted;
+        stats.max_count = std::max<uint64_t>(stats.max_count, run_max);
     });
+}
 
-    for(auto& t : counter_threads) {
-        t.join();
+template<typename T>
+void KmerCounter<T>::countFiltered(Kmer const& kmer, size_t table_ix, CounterThreadStats& stats)
+{
+    if(!singleton_filter->testAndSet(kmer)) {
+        return;
     }
 
-    reader_thread.join();
+    auto update_spectrum = [&stats] (count_type old_count, count_type new_count) {
+        stats.spectrum.update(old_count, new_count);
+    };
 
-    return *this;
+    count_type curr_count;
+    bool inserted;
+    std::tie(curr_count, inserted) = tables[table_ix].increment(kmer, 1, update_spectrum);
+
+    if(inserted) {
+        // Also count the first occurrence, which only went into the filter
+        curr_count = tables[table_ix].increment(kmer, 1, update_spectrum).first;
+        ++stats.num_unique;
+    }
+
+    stats.max_count = std::max<uint64_t>(stats.max_count, curr_count);
 }
 
+template<typename T>
+uint64_t KmerCounter<T>::getFilteredSingletons() const
+{
+    if(!singleton_filter) {
+        return 0;
+    }
+
+    uint64_t num_distinct = singleton_filter->estimateSize();
+    return num_distinct > getUniqueKmers() ? num_distinct - getUniqueKmers() : 0;
+}
 
-void KmerCounter::counterThread()
+template<typename T>
+void KmerCounter<T>::mergeThreadStats(CounterThreadStats const& stats)
 {
-    while(true) {
-        // Wait until sequences are available in the queue
-        unique_lock<mutex> guard(queue_lock);
-        sequence_ready.wait(guard, [&] () { return !seq_queue.empty() || finished_reading; });
+    num_kmers += stats.num_kmers;
+    num_unique += stats.num_unique;
 
-        if(seq_queue.empty() && finished_reading) {
-            return;
+    {
+        lock_guard<mutex> guard(spectrum_lock);
+        spectrum.merge(stats.spectrum);
+    }
+
+    auto thread_max = static_cast<count_type>(stats.max_count);
+    count_type curr_max = max_count.load();
+    while(thread_max > curr_max && !max_count.compare_exchange_weak(curr_max, thread_max)) { }
+}
+
+namespace {
+
+/**
+ * Temporary bucket files with super-k-mers for out-of-core counting. Each bucket holds the super-k-mers of a
+ * contiguous range of tables.
+ *
+ * Each record consists of the table index (uint32), the super-k-mer length (uint32), and the NUL-terminated
+ * super-k-mer sequence.
+ */
+class SuperKmerBuckets {
+public:
+    SuperKmerBuckets(std::string const& tmp_dir, size_t num_tables, size_t num_buckets) :
+        locks(num_buckets), table_kmers(num_tables)
+    {
+        std::string dir = tmp_dir;
+        if(dir.empty()) {
+            char const* env_tmp = std::getenv("TMPDIR");
+            dir = env_tmp != nullptr ? env_tmp : "/tmp";
         }
 
-        // Obtain block of sequences to count
-        unique_ptr<vector<string>> sequences = move(seq_queue.front());
-        seq_queue.pop();
-        guard.unlock();
+        std::stringstream prefix;
+        prefix << dir << "/pyfrost_kmers." << getpid() << "." << reinterpret_cast<uintptr_t>(this) << ".";
+        path_prefix = prefix.str();
 
-        for(auto const& sequence : *sequences) {
-            KmerIterator kmer_iter(sequence.c_str()), kmer_end;
-            minHashIterator<RepHash> it_min(sequence.c_str(), sequence.size(), Kmer::k, Minimizer::g, RepHash(), true);
+        size_t tables_per_bucket = num_tables / num_buckets;
+        for(size_t i = 0; i < num_buckets; ++i) {
+            buckets.push_back({newPath(), i * tables_per_bucket, (i + 1) * tables_per_bucket});
+            files.emplace_back(buckets.back().path, std::ios::binary | std::ios::trunc);
 
-            for(; kmer_iter != kmer_end; ++kmer_iter) {
-                std::pair<Kmer, int> const p = *kmer_iter; // K-mer hash and position in sequence
-                Kmer kmer = canonical ? p.first.rep() : p.first;
-                ++num_kmers;
+            if(!files.back()) {
+                throw std::runtime_error("Could not create temporary bucket file " + buckets.back().path);
+            }
+        }
+    }
+
+    ~SuperKmerBuckets() {
+        files.clear();
+        for(auto const& bucket : buckets) {
+            std::remove(bucket.path.c_str());
+        }
+    }
 
-                // Move minimizer position, also takes into account if one or more k-mers were skipped because they
-                // contained a non-ACGT char.
-                // Minimizer hash serves as hash table index
-                it_min += (p.second - it_min.getKmerPosition());
-                uint64_t minimizer_hash = it_min.getHash();
-                size_t table_ix = minimizer_hash % tables.size();
+    static void appendRecord(std::string& buffer, size_t table_ix, char const* seq, size_t len) {
+        auto table = static_cast<uint32_t>(table_ix);
+        auto length = static_cast<uint32_t>(len);
 
-                unique_lock<mutex> table_guard(table_locks[table_ix]);
-                kmercount_t curr_count = 0;
-                if(tables[table_ix].contains(kmer)) {
-                    curr_count = tables[table_ix][kmer];
-                } else {
-                    ++num_unique;
-                }
+        buffer.append(reinterpret_cast<char const*>(&table), sizeof(table));
+        buffer.append(reinterpret_cast<char const*>(&length), sizeof(length));
+        buffer.append(seq, len);
+        buffer.push_back('\0');
+    }
 
-                // Check if counter is not saturated
-                if(curr_count < 0xFFFF){
-                    ++curr_count;
+    /**
+     * Append whole records from `in` to `block` until it holds at least `block_size` bytes. Returns false if there
+     * were no records left.
+     */
+    static bool readRecords(std::istream& in, std::string& block, size_t block_size) {
+        block.clear();
+
+        char header[2 * sizeof(uint32_t)];
+        while(block.size() < block_size) {
+            if(!in.read(header, sizeof(header))) {
+                if(in.gcount() != 0) {
+                    throw std::runtime_error("Super-k-mer bucket file is truncated.");
                 }
 
-                tables[table_ix].insert_or_assign(kmer, curr_count);
+                break;
+            }
 
-                if(curr_count > max_count.load()) {
-                    max_count = curr_count;
+            uint32_t length;
+            std::memcpy(&length, header + sizeof(uint32_t), sizeof(length));
+
+            size_t offset = block.size();
+            block.append(header, sizeof(header));
+            block.resize(offset + sizeof(header) + length + 1);
+            in.read(&block[offset + sizeof(header)], length + 1);
+
+            if(in.gcount() != static_cast<std::streamsize>(length) + 1) {
+                throw std::runtime_error("Super-k-mer bucket file is truncated.");
+            }
+        }
+
+        return !block.empty();
+    }
+
+    /**
+     * Call `func(table_ix, seq, len)` for each record in a block read by `readRecords`.
+     */
+    template<typename F>
+    static void forEachRecord(std::string const& block, F&& func) {
+        for(size_t offset = 0; offset < block.size(); ) {
+            uint32_t table_ix;
+            uint32_t length;
+            std::memcpy(&table_ix, block.data() + offset, sizeof(table_ix));
+            std::memcpy(&length, block.data() + offset + sizeof(uint32_t), sizeof(length));
+
+            func(table_ix, block.data() + offset + 2 * sizeof(uint32_t), length);
+            offset += 2 * sizeof(uint32_t) + length + 1;
+        }
+    }
+
+    size_t bucketOf(size_t table_ix) const {
+        return table_ix / (table_kmers.size() / locks.size());
+    }
+
+    void write(size_t bucket, std::string& buffer) {
+        lock_guard<mutex> guard(locks[bucket]);
+        files[bucket].write(buffer.data(), buffer.size());
+
+        buffer.clear();
+    }
+
+    /**
+     * Add the number of k-mers a thread wrote for each table.
+     */
+    void addKmers(vector<uint64_t> const& kmers_per_table) {
+        for(size_t table_ix = 0; table_ix < kmers_per_table.size(); ++table_ix) {
+            table_kmers[table_ix] += kmers_per_table[table_ix];
+        }
+    }
+
+    void finishWriting() {
+        for(auto& f : files) {
+            f.close();
+            if(!f) {
+                throw std::runtime_error("Error while writing super-k-mer bucket files.");
+            }
+        }
+
+        files.clear();
+    }
+
+    /**
+     * Split a bucket into smaller buckets of at most `max_kmers` k-mers, by dividing its range of tables. A single
+     * table is never split, so a new bucket holding one table can still exceed `max_kmers`.
+     */
+    void split(size_t bucket, uint64_t max_kmers) {
+        Bucket old_bucket = buckets[bucket];
+
+        vector<Bucket> new_buckets;
+        uint64_t bucket_kmers = 0;
+        for(size_t table_ix = old_bucket.table_begin; table_ix < old_bucket.table_end; ++table_ix) {
+            uint64_t kmers = table_kmers[table_ix].load();
+            if(new_buckets.empty() || bucket_kmers + kmers > max_kmers) {
+                new_buckets.push_back({newPath(), table_ix, table_ix});
+                bucket_kmers = 0;
+            }
+
+            new_buckets.back().table_end = table_ix + 1;
+            bucket_kmers += kmers;
+        }
+
+        if(new_buckets.size() < 2) {
+            return;
+        }
+
+        vector<std::ofstream> new_files;
+        for(auto const& new_bucket : new_buckets) {
+            new_files.emplace_back(new_bucket.path, std::ios::binary | std::ios::trunc);
+
+            if(!new_files.back()) {
+                throw std::runtime_error("Could not create temporary bucket file " + new_bucket.path);
+            }
+        }
+
+        // Stream the records into the new buckets, the new buckets are in table order
+        std::ifstream ifile(old_bucket.path, std::ios::binary);
+        std::string block;
+        std::string record;
+        while(readRecords(ifile, block, BLOCK_SIZE)) {
+            forEachRecord(block, [&] (size_t table_ix, char const* seq, size_t len) {
+                auto it = std::upper_bound(new_buckets.begin(), new_buckets.end(), table_ix,
+                                           [] (size_t t, Bucket const& b) { return t < b.table_end; });
+
+                record.clear();
+                appendRecord(record, table_ix, seq, len);
+                new_files[it - new_buckets.begin()].write(record.data(), record.size());
+            });
+        }
+
+        ifile.close();
+        std::remove(old_bucket.path.c_str());
+
+        buckets.erase(buckets.begin() + bucket);
+        buckets.insert(buckets.begin() + bucket, new_buckets.begin(), new_buckets.end());
+
+        for(auto& f : new_files) {
+            f.close();
+            if(!f) {
+                throw std::runtime_error("Error while writing super-k-mer bucket files.");
+            }
+        }
+    }
+
+    size_t size() const {
+        return buckets.size();
+    }
+
+    std::string const& path(size_t bucket) const {
+        return buckets[bucket].path;
+    }
+
+    size_t tableBegin(size_t bucket) const {
+        return buckets[bucket].table_begin;
+    }
+
+    size_t tableEnd(size_t bucket) const {
+        return buckets[bucket].table_end;
+    }
+
+    uint64_t numKmers(size_t bucket) const {
+        uint64_t total = 0;
+        for(size_t table_ix = buckets[bucket].table_begin; table_ix < buckets[bucket].table_end; ++table_ix) {
+            total += table_kmers[table_ix].load();
+        }
+
+        return total;
+    }
+
+    /// Size in bytes of the blocks of records read at once
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+private:
+    struct Bucket {
+        std::string path;
+        size_t table_begin;
+        size_t table_end;
+    };
+
+    std::string newPath() {
+        return path_prefix + std::to_string(next_file++) + ".bin";
+    }
+
+    std::string path_prefix;
+    size_t next_file = 0;
+
+    vector<Bucket> buckets;
+    vector<std::ofstream> files;
+    vector<mutex> locks;
+    vector<std::atomic<uint64_t>> table_kmers;
+};
+
+/**
+ * Read-only stream buffer over a block of memory, to deserialize a file that was read into memory.
+ */
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(vector<char>& data) {
+        setg(data.data(), data.data(), data.data() + data.size());
+    }
+};
+
+}
+
+template<typename T>
+void KmerCounter<T>::countKmersFilesExternal(std::vector<std::string> const& files, std::string const& output_file,
+                                          std::string const& tmp_dir, size_t max_memory, size_t num_buckets)
+{
+    if(num_unique.load() > 0) {
+        throw std::runtime_error("Out-of-core counting is only supported on an empty KmerCounter.");
+    }
+
+    // Each bucket holds a contiguous range of tables, so a group of buckets can be written out in table order
+    size_t buckets = 1;
+    while(buckets * 2 <= std::min(num_buckets, tables.size())) {
+        buckets *= 2;
+    }
+
+    // Open the output file first, so an invalid path fails before counting
+    std::ofstream ofile(output_file, std::ios::binary);
+    if(!ofile) {
+        throw std::runtime_error("Could not open " + output_file + " for writing.");
+    }
+
+    SuperKmerBuckets bucket_files(tmp_dir, tables.size(), buckets);
+
+    // Pass 1: spill super-k-mers to the bucket files
+    pipeline.run(files, [&] () {
+        CounterThreadStats stats;
+        vector<std::string> buffers(buckets);
+        vector<uint64_t> table_kmers(tables.size(), 0);
+
+        pipeline.processQueue([&] (string const& sequence) {
+            forEachSuperKmer(sequence, tables.size(), canonical,
+                             [&] (size_t table_ix, KmerRun const& run, int run_start) {
+                size_t bucket = bucket_files.bucketOf(table_ix);
+                SuperKmerBuckets::appendRecord(buffers[bucket], table_ix, sequence.c_str() + run_start,
+                                               run.size() + Kmer::k - 1);
+
+                table_kmers[table_ix] += run.size();
+                stats.num_kmers += run.size();
+
+                if(buffers[bucket].size() >= 16384) {
+                    bucket_files.write(bucket, buffers[bucket]);
                 }
+            });
+        });
+
+        for(size_t bucket = 0; bucket < buckets; ++bucket) {
+            bucket_files.write(bucket, buffers[bucket]);
+        }
+
+        bucket_files.addKmers(table_kmers);
+        num_kmers += stats.num_kmers;
+    });
+
+    bucket_files.finishWriting();
+
+    // Pass 2: count groups of buckets that fit in the memory budget, and stream the resulting tables to the output
+    // file. Writes the same layout as `save`.
+    cereal::BinaryOutputArchive archive(ofile);
+    archive(k, g, canonical);
+    save_count_width<T>(archive);
+    archive(cereal::make_size_tag(static_cast<cereal::size_type>(tables.size())));
+
+    // Rough upper bound of memory use per k-mer: each k-mer in a bucket could be unique, and tables are on average
+    // half full.
+    size_t const bytes_per_kmer = 2 * (sizeof(Kmer) + sizeof(T) + 1);
+    uint64_t const max_kmers = std::max(size_t(1), max_memory / bytes_per_kmer);
+
+    size_t first_bucket = 0;
+    while(first_bucket < bucket_files.size()) {
+        // Skewed minimizers can fill a bucket beyond the memory budget on its own, split those on their tables first
+        if(bucket_files.numKmers(first_bucket) > max_kmers) {
+            bucket_files.split(first_bucket, max_kmers);
+        }
+
+        size_t last_bucket = first_bucket + 1;
+        uint64_t group_kmers = bucket_files.numKmers(first_bucket);
+        while(last_bucket < bucket_files.size() && group_kmers + bucket_files.numKmers(last_bucket) <= max_kmers) {
+            group_kmers += bucket_files.numKmers(last_bucket);
+            ++last_bucket;
+        }
 
-                table_guard.unlock();
+        for(size_t bucket = first_bucket; bucket < last_bucket; ++bucket) {
+            // Records are streamed from the bucket file in blocks, shared by the counting threads
+            std::ifstream ifile(bucket_files.path(bucket), std::ios::binary);
+            mutex read_lock;
+
+            vector<thread> count_threads;
+            for(size_t i = 0; i < num_threads; ++i) {
+                count_threads.emplace_back([&] () {
+                    CounterThreadStats stats;
+                    KmerScanner scanner;
+                    std::string block;
+
+                    while(true) {
+                        {
+                            lock_guard<mutex> guard(read_lock);
+                            if(!SuperKmerBuckets::readRecords(ifile, block, SuperKmerBuckets::BLOCK_SIZE)) {
+                                break;
+                            }
+                        }
+
+                        SuperKmerBuckets::forEachRecord(block, [&] (size_t table_ix, char const* seq, size_t len) {
+                            // The table index is stored with the super-k-mer, so minimizers aren't needed
+                            scanner.scan(seq, len, canonical, false);
+                            auto const& run = scanner.getKmers();
+
+                            size_t num_inserted;
+                            count_type run_max;
+                            std::tie(num_inserted, run_max) = tables[table_ix].incrementBatch(run.begin(), run.end(),
+                                [&stats] (count_type old_count, count_type new_count) {
+                                    stats.spectrum.update(old_count, new_count);
+                                });
+
+                            stats.num_unique += num_inserted;
+                            stats.max_count = std::max<uint64_t>(stats.max_count, run_max);
+                        });
+                    }
+
+                    // K-mers were already counted in the first pass
+                    mergeThreadStats(stats);
+                });
+            }
+
+            for(auto& t : count_threads) {
+                t.join();
             }
         }
+
+        size_t table_end = bucket_files.tableEnd(last_bucket - 1);
+        for(size_t table_ix = bucket_files.tableBegin(first_bucket); table_ix < table_end; ++table_ix) {
+            archive(tables[table_ix]);
+            tables[table_ix] = table_type();
+        }
+
+        first_bucket = last_bucket;
+    }
+
+    archive(num_kmers.load(), num_unique.load(), max_count.load());
+
+    ofile.close();
+    if(!ofile) {
+        throw std::runtime_error("Error while writing " + output_file + ".");
     }
 }
 
-kmercount_t KmerCounter::query(const Kmer &qry) const
+template<typename T>
+KmerCounter<T>& KmerCounter<T>::merge(KmerCounter const& other)
 {
-    Kmer kmer = canonical ? qry.rep() : qry;
-    string kmer_str = kmer.toString();
+    if(k != other.k || g != other.g || canonical != other.canonical) {
+        throw std::runtime_error("Can only merge KmerCounters with the same k, g and canonical setting.");
+    }
+
+    if(&other == this) {
+        KmerCounter copy(other);
+        return merge(copy);
+    }
+
+    std::atomic<size_t> next_table(0);
+    vector<CounterThreadStats> thread_stats(std::max(size_t(1), num_threads));
+
+    vector<thread> threads;
+    for(size_t i = 0; i < thread_stats.size(); ++i) {
+        threads.emplace_back([&, i] () {
+            CounterThreadStats& stats = thread_stats[i];
+            auto update_spectrum = [&stats] (count_type old_count, count_type new_count) {
+                stats.spectrum.update(old_count, new_count);
+            };
+
+            for(size_t table_ix = next_table++; table_ix < other.tables.size(); table_ix = next_table++) {
+                if(tables.size() == other.tables.size()) {
+                    size_t num_inserted;
+                    count_type table_max;
+                    std::tie(num_inserted, table_max) = tables[table_ix].merge(other.tables[table_ix], update_spectrum);
+
+                    stats.num_unique += num_inserted;
+                    stats.max_count = std::max<uint64_t>(stats.max_count, table_max);
+                } else {
+                    for(auto const& e : other.tables[table_ix]) {
+                        count_type new_count;
+                        bool inserted;
+                        std::tie(new_count, inserted) = tables[partitionOf(e.first)].increment(e.first, e.second,
+                                                                                               update_spectrum);
+
+                        stats.num_unique += inserted;
+                        stats.max_count = std::max<uint64_t>(stats.max_count, new_count);
+                    }
+                }
+            }
+        });
+    }
+
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    for(auto const& stats : thread_stats) {
+        mergeThreadStats(stats);
+    }
+
+    num_kmers += other.getNumKmers();
+
+    return *this;
+}
+
+template<typename T>
+KmerCounter<T> KmerCounter<T>::mergeFiles(vector<string> const& files, size_t num_threads)
+{
+    // Files are read from disk in the background while the previous one is merged. Deserializing a counter sets the
+    // global k-mer and minimizer size, so that only happens on this thread.
+    auto read_file = [] (string const& filepath) {
+        std::ifstream ifile(filepath, std::ios::binary | std::ios::ate);
+        if(!ifile) {
+            throw std::runtime_error("Could not open " + filepath + ".");
+        }
+
+        vector<char> data(static_cast<size_t>(ifile.tellg()));
+        ifile.seekg(0);
+        if(!ifile.read(data.data(), data.size())) {
+            throw std::runtime_error("Could not read " + filepath + ".");
+        }
+
+        return data;
+    };
+
+    if(files.empty()) {
+        throw std::runtime_error("No KmerCounter files given to merge.");
+    }
+
+    KmerCounter<T> merged;
+    {
+        vector<char> data = read_file(files[0]);
+        MemoryBuffer buffer(data);
+        std::istream stream(&buffer);
+        cereal::BinaryInputArchive archive(stream);
+        archive(merged);
+    }
+
+    merged.num_threads = num_threads;
+
+    std::future<vector<char>> next;
+    if(files.size() > 1) {
+        next = std::async(std::launch::async, read_file, std::cref(files[1]));
+    }
+
+    for(size_t i = 1; i < files.size(); ++i) {
+        vector<char> data = next.get();
+        if(i + 1 < files.size()) {
+            next = std::async(std::launch::async, read_file, std::cref(files[i + 1]));
+        }
+
+        // Check the header before loading, as loading a counter with another k would change the k-mer size of the
+        // merged counter too
+        {
+            MemoryBuffer buffer(data);
+            std::istream stream(&buffer);
+            cereal::BinaryInputArchive archive(stream);
+
+            size_t file_k, file_g;
+            bool file_canonical;
+            archive(file_k, file_g, file_canonical);
 
-    minHashKmer<RepHash> it_min(kmer_str.c_str(), Kmer::k, Minimizer::g, RepHash(), true), it_min_end;
-    for(; it_min != it_min_end; ++it_min) {
-        uint64_t minimizer_hash = it_min.getHash();
-        size_t table_ix = minimizer_hash % tables.size();
+            if(file_k != merged.k || file_g != merged.g || file_canonical != merged.canonical) {
+                throw std::runtime_error("Can only merge KmerCounters with the same k, g and canonical setting, "
+                                         + files[i] + " differs from " + files[0] + ".");
+            }
+        }
 
-        auto it = tables[table_ix].find(kmer);
-        if(it != tables[table_ix].end()) {
-            return it->second;
+        KmerCounter<T> curr;
+        {
+            MemoryBuffer buffer(data);
+            std::istream stream(&buffer);
+            cereal::BinaryInputArchive archive(stream);
+            archive(curr);
         }
+
+        data = vector<char>();
+        merged.merge(curr);
     }
 
-    return 0;
+    return merged;
+}
+
+template<typename T>
+typename KmerCounter<T>::count_type KmerCounter<T>::query(const Kmer &qry) const
+{
+    Kmer kmer = canonical ? qry.rep() : qry;
+
+    return tables[partitionOf(kmer)].find(kmer);
 }
 
-kmercount_t KmerCounter::query(char const* qry) const
+template<typename T>
+typename KmerCounter<T>::count_type KmerCounter<T>::query(char const* qry) const
 {
     return query(Kmer(qry));
 }
 
+template<typename T>
+template<typename F>
+void KmerCounter<T>::queryParallel(size_t n, F&& get_kmer, count_type* output) const
+{
+    size_t query_threads = std::max(size_t(1), std::min(num_threads, n / 1024));
+    size_t chunk_size = (n + query_threads - 1) / query_threads;
+
+    vector<thread> threads;
+    for(size_t t = 0; t < query_threads; ++t) {
+        threads.emplace_back([&, t] () {
+            size_t end = std::min(n, (t + 1) * chunk_size);
+            for(size_t i = t * chunk_size; i < end; ++i) {
+                output[i] = query(get_kmer(i));
+            }
+        });
+    }
+
+    for(auto& t : threads) {
+        t.join();
+    }
+}
 
-std::vector<kmercount_t> KmerCounter::getAllCounts() {
-    std::vector<kmercount_t> counts(getUniqueKmers());
+template<typename T>
+std::vector<typename KmerCounter<T>::count_type> KmerCounter<T>::queryMany(vector<Kmer> const& kmers) const
+{
+    vector<count_type> counts(kmers.size());
+    queryParallel(kmers.size(), [&kmers] (size_t i) { return kmers[i]; }, counts.data());
 
-    for(auto tuple : *this) {
-        counts.push_back(tuple.second);
+    return counts;
+}
+
+template<typename T>
+std::vector<typename KmerCounter<T>::count_type> KmerCounter<T>::queryMany(uint64_t const* words,
+                                                                         size_t num_kmers) const
+{
+    vector<count_type> counts(num_kmers);
+    queryParallel(num_kmers, [words] (size_t i) { return kmer_from_words(words + i * KMER_WORDS); }, counts.data());
+
+    return counts;
+}
+
+template<typename T>
+std::vector<typename KmerCounter<T>::count_type> KmerCounter<T>::querySequence(string const& sequence) const
+{
+    if(sequence.size() < Kmer::k) {
+        return {};
+    }
+
+    // The scanner gives the partition of each k-mer from its rolling minimizer, so no need for `partitionOf`
+    thread_local KmerScanner scanner;
+    size_t num_scanned = scanner.scan(sequence, canonical, true);
+
+    vector<count_type> counts(sequence.size() - Kmer::k + 1, 0);
+    for(size_t i = 0; i < num_scanned; ++i) {
+        counts[scanner.position(i)] = tables[scanner.minimizerHash(i) % tables.size()].find(scanner.kmer(i));
     }
 
     return counts;
 }
 
 
-std::vector<uint64_t> KmerCounter::getFrequencySpectrum()
+template<typename T>
+template<typename F>
+void KmerCounter<T>::forEachTableParallel(F&& func) const
 {
-    std::vector<uint64_t> spectrum(getMaxCount());
+    std::atomic<size_t> next_table(0);
+    size_t reduce_threads = std::max(size_t(1), std::min(num_threads, tables.size()));
+
+    vector<thread> threads;
+    for(size_t i = 0; i < reduce_threads; ++i) {
+        threads.emplace_back([&] () {
+            for(size_t table_ix = next_table++; table_ix < tables.size(); table_ix = next_table++) {
+                func(table_ix);
+            }
+        });
+    }
 
-    for(auto tuple : *this) {
-        auto count = tuple.second;
+    for(auto& t : threads) {
+        t.join();
+    }
+}
 
-        ++spectrum[count-1];
+template<typename T>
+std::vector<size_t> KmerCounter<T>::tableOffsets() const
+{
+    vector<size_t> offsets(tables.size() + 1, 0);
+    for(size_t i = 0; i < tables.size(); ++i) {
+        offsets[i + 1] = offsets[i] + tables[i].size();
     }
 
-    return spectrum;
+    return offsets;
 }
 
+template<typename T>
+std::vector<typename KmerCounter<T>::count_type> KmerCounter<T>::getAllCounts() const {
+    vector<size_t> offsets = tableOffsets();
+    std::vector<count_type> counts(offsets.back());
+
+    forEachTableParallel([&] (size_t table_ix) {
+        size_t i = offsets[table_ix];
+        for(auto const& e : tables[table_ix]) {
+            counts[i++] = e.second;
+        }
+    });
 
-void define_KmerCounter(py::module& m) {
-    auto py_KmerCounter = py::class_<KmerCounter>(m, "KmerCounter")
-        .def(py::init<size_t, size_t, bool, size_t, size_t, size_t>(),
+    return counts;
+}
+
+template<typename T>
+void KmerCounter<T>::exportArrays(count_type count_min, count_type count_max, vector<uint64_t>& words,
+                                  vector<count_type>& counts) const
+{
+    // First pass counts the selected k-mers in each table, so each table can be written to its own output range
+    vector<size_t> offsets(tables.size() + 1, 0);
+    forEachTableParallel([&] (size_t table_ix) {
+        size_t num_selected = 0;
+        for(auto const& e : tables[table_ix]) {
+            num_selected += e.second >= count_min && e.second <= count_max;
+        }
+
+        offsets[table_ix + 1] = num_selected;
+    });
+
+    for(size_t i = 0; i < tables.size(); ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    words.resize(offsets.back() * KMER_WORDS);
+    counts.resize(offsets.back());
+
+    forEachTableParallel([&] (size_t table_ix) {
+        size_t i = offsets[table_ix];
+        for(auto const& e : tables[table_ix]) {
+            if(e.second >= count_min && e.second <= count_max) {
+                kmer_to_words(e.first, &words[i * KMER_WORDS]);
+                counts[i] = e.second;
+                ++i;
+            }
+        }
+    });
+}
+
+template<typename T>
+bool KmerCounter<T>::partitionsMatch() const
+{
+    for(size_t table_ix = 0; table_ix < tables.size(); ++table_ix) {
+        size_t checked = 0;
+        for(auto it = tables[table_ix].begin(); it != tables[table_ix].end() && checked < 4; ++it, ++checked) {
+            if(partitionOf((*it).first) != table_ix) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+void KmerCounter<T>::repartition()
+{
+    vector<table_type> old_tables(tables.size());
+    std::swap(old_tables, tables);
+
+    // Tables support concurrent increments, so each thread can move the k-mers of its source tables directly
+    forEachTableParallel([&] (size_t table_ix) {
+        for(auto const& e : old_tables[table_ix]) {
+            tables[partitionOf(e.first)].increment(e.first, e.second);
+        }
+
+        old_tables[table_ix] = table_type();
+    });
+}
+
+template<typename T>
+void KmerCounter<T>::rebuildSpectrum()
+{
+    spectrum.clear();
+
+    forEachTableParallel([&] (size_t table_ix) {
+        KmerSpectrum table_spectrum;
+        for(auto const& e : tables[table_ix]) {
+            table_spectrum.add(e.second, 1);
+        }
+
+        lock_guard<mutex> guard(spectrum_lock);
+        spectrum.merge(table_spectrum);
+    });
+}
+
+
+template<typename T>
+void KmerCounter<T>::collectEntries(vector<Kmer>& keys, vector<count_type>& counts) const
+{
+    vector<size_t> offsets = tableOffsets();
+    keys.resize(offsets.back());
+    counts.resize(offsets.back());
+
+    forEachTableParallel([&] (size_t table_ix) {
+        size_t i = offsets[table_ix];
+        for(auto const& e : tables[table_ix]) {
+            keys[i] = e.first;
+            counts[i] = e.second;
+            ++i;
+        }
+    });
+}
+
+
+template<typename T>
+FrozenKmerCounter<T> KmerCounter<T>::freeze() const
+{
+    vector<Kmer> keys;
+    vector<count_type> counts;
+    collectEntries(keys, counts);
+
+    return {k, g, canonical, keys, counts, getNumKmers(), getMaxCount(), num_threads};
+}
+
+
+template<typename T>
+void KmerCounter<T>::saveSorted(std::string const& filepath) const
+{
+    vector<Kmer> keys;
+    vector<count_type> counts;
+    collectEntries(keys, counts);
+
+    MappedKmerCounter::write(filepath, k, g, canonical, keys, counts, getNumKmers(), getMaxCount(), num_threads);
+}
+
+
+template<typename T>
+uint64_t KmerCounter<T>::writeSolidKmers(std::string const& filepath, count_type min_count) const
+{
+    std::ofstream ofile(filepath);
+    if(!ofile) {
+        throw std::runtime_error("Could not open " + filepath + " for writing.");
+    }
+
+    size_t const kmers_per_record = 1024;
+
+    uint64_t num_written = 0;
+    size_t record_kmers = 0;
+    string record;
+    auto flush_record = [&] () {
+        ofile << '>' << num_written << '\n' << record << '\n';
+        record.clear();
+        record_kmers = 0;
+    };
+
+    for(auto const& table : tables) {
+        for(auto const& e : table) {
+            if(e.second < min_count) {
+                continue;
+            }
+
+            if(record_kmers > 0) {
+                record.push_back('N');
+            }
+
+            record += e.first.toString();
+            ++record_kmers;
+            ++num_written;
+
+            if(record_kmers == kmers_per_record) {
+                flush_record();
+            }
+        }
+    }
+
+    if(record_kmers > 0) {
+        flush_record();
+    }
+
+    if(!ofile) {
+        throw std::runtime_error("Error while writing " + filepath + ".");
+    }
+
+    return num_written;
+}
+
+
+template<typename T>
+std::vector<uint64_t> KmerCounter<T>::getFrequencySpectrum() const
+{
+    std::vector<uint64_t> counts_spectrum = spectrum.toVector(getMaxCount());
+
+    // Singletons filtered out of the tables are only known approximately
+    if(singleton_filter) {
+        if(counts_spectrum.empty()) {
+            counts_spectrum.resize(1);
+        }
+
+        counts_spectrum[0] = getFilteredSingletons();
+    }
+
+    return counts_spectrum;
+}
+
+
+
+template<typename T>
+void define_KmerCounter(py::module& m, char const* name) {
+    auto py_KmerCounter = py::class_<KmerCounter<T>>(m, name, py::module_local())
+        .def(py::init<size_t, size_t, bool, size_t, size_t, size_t, bool, size_t, size_t>(),
             py::arg("k"), py::arg("g") = 0, py::arg("canonical") = true,
-            py::arg("num_threads") = 2, py::arg("table_bits") = 10, py::arg("batch_size") = 100000)
-        .def("count_kmers", &KmerCounter::countKmers, py::call_guard<py::gil_scoped_release>())
-        .def("count_kmers_files", &KmerCounter::countKmersFiles, py::call_guard<py::gil_scoped_release>())
-        .def("query", py::overload_cast<Kmer const&>(&KmerCounter::query, py::const_))
-        .def("query", py::overload_cast<char const*>(&KmerCounter::query, py::const_))
-
-        .def("all_counts", [] (KmerCounter& self) {
-            return as_pyarray<std::vector<kmercount_t>>(std::move(self.getAllCounts()));
+            py::arg("num_threads") = 2, py::arg("table_bits") = 10, py::arg("batch_size") = 100000,
+            py::arg("superkmers") = true, py::arg("num_readers") = 1, py::arg("singleton_filter_bits") = 0)
+        .def("count_kmers", &KmerCounter<T>::countKmers, py::call_guard<py::gil_scoped_release>())
+        .def("count_kmers_files", &KmerCounter<T>::countKmersFiles, py::call_guard<py::gil_scoped_release>())
+
+        .def("start", &KmerCounter<T>::start,
+            "Start a streaming session, with a pool of counter threads that count sequences passed to `feed`.")
+        .def("feed", [] (KmerCounter<T>& self, vector<string> batch) {
+            py::gil_scoped_release release;
+            self.feed(std::move(batch));
+        }, py::arg("batch"),
+            "Queue a list of sequences (str or bytes) for counting. Blocks while the queue of pending batches is full.")
+        .def("finish", &KmerCounter<T>::finish, py::return_value_policy::reference_internal,
+            py::call_guard<py::gil_scoped_release>(),
+            "Wait until all fed sequences are counted, and end the streaming session.")
+        .def_property_readonly("is_streaming", &KmerCounter<T>::isStreaming)
+        .def("count_kmers_files_external", &KmerCounter<T>::countKmersFilesExternal,
+            py::arg("files"), py::arg("output_file"), py::arg("tmp_dir") = "",
+            py::arg("max_memory") = size_t(4) << 30, py::arg("num_buckets") = 64,
+            py::call_guard<py::gil_scoped_release>(),
+            "Count k-mers using temporary bucket files on disk to limit memory usage, and write the resulting counter "
+            "to `output_file`.")
+        .def("merge", &KmerCounter<T>::merge, py::arg("other"), py::return_value_policy::reference_internal,
+            py::call_guard<py::gil_scoped_release>(),
+            "Add the counts of another KmerCounter with the same k, g and canonical setting to this one.")
+        .def_static("merge_files", &KmerCounter<T>::mergeFiles, py::arg("files"), py::arg("num_threads") = 2,
+            py::call_guard<py::gil_scoped_release>(),
+            "Merge KmerCounters saved with `save` into a single KmerCounter.")
+
+        .def("query", py::overload_cast<Kmer const&>(&KmerCounter<T>::query, py::const_))
+        .def("query", py::overload_cast<char const*>(&KmerCounter<T>::query, py::const_))
+
+        .def("query_many", [] (KmerCounter<T> const& self, string const& sequence) {
+            vector<typename KmerCounter<T>::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.querySequence(sequence);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("sequence"), "Query all k-mers in a sequence, returns a numpy array with a count per position.")
+
+        .def("query_many", [] (KmerCounter<T> const& self,
+                               py::array_t<uint64_t, py::array::c_style | py::array::forcecast> const& kmers) {
+            if(kmers.ndim() != 2 || static_cast<size_t>(kmers.shape(1)) != KMER_WORDS) {
+                throw py::value_error("Expected an array of packed k-mers with shape (n, "
+                                      + std::to_string(KMER_WORDS) + ").");
+            }
+
+            uint64_t const* words = kmers.data();
+            auto num_kmers = static_cast<size_t>(kmers.shape(0));
+
+            vector<typename KmerCounter<T>::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.queryMany(words, num_kmers);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("kmers"), "Query an array of packed k-mers, returns a numpy array with the count of each k-mer.")
+
+        .def("query_many", [] (KmerCounter<T> const& self, vector<Kmer> const& kmers) {
+            vector<typename KmerCounter<T>::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.queryMany(kmers);
+            }
+
+            return as_pyarray(std::move(counts));
+        }, py::arg("kmers"), "Query a list of k-mers, returns a numpy array with the count of each k-mer.")
+
+        .def("all_counts", [] (KmerCounter<T> const& self) {
+            vector<typename KmerCounter<T>::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                counts = self.getAllCounts();
+            }
+
+            return as_pyarray(std::move(counts));
         })
 
-        .def("frequency_spectrum", [] (KmerCounter& self) {
-            return as_pyarray<std::vector<uint64_t>>(std::move(self.getFrequencySpectrum()));
+        .def("to_arrays", [] (KmerCounter<T> const& self, typename KmerCounter<T>::count_type min_count,
+                              typename KmerCounter<T>::count_type max_count) {
+            vector<uint64_t> words;
+            vector<typename KmerCounter<T>::count_type> counts;
+            {
+                py::gil_scoped_release release;
+                self.exportArrays(min_count, max_count, words, counts);
+            }
+
+            size_t num_kmers = counts.size();
+            return py::make_tuple(as_pyarray(std::move(words), {num_kmers, KMER_WORDS}),
+                                  as_pyarray(std::move(counts)));
+        }, py::arg("min_count") = 1,
+            py::arg("max_count") =
+                static_cast<typename KmerCounter<T>::count_type>(KmerCounter<T>::table_type::MAX_COUNT),
+            "Export k-mers and counts to numpy arrays: a (n, KMER_WORDS) uint64 array of 2-bit packed k-mers, and an "
+            "array with the count of each k-mer. Only k-mers with a count in [min_count, max_count] are included.")
+
+        .def("frequency_spectrum", [] (KmerCounter<T> const& self) {
+            return as_pyarray(self.getFrequencySpectrum());
         })
 
-        .def("__getitem__", py::overload_cast<Kmer const&>(&KmerCounter::query, py::const_))
-        .def("__getitem__", py::overload_cast<char const*>(&KmerCounter::query, py::const_))
+        .def("freeze", &KmerCounter<T>::freeze, py::call_guard<py::gil_scoped_release>(),
+            "Create a read-only, memory efficient version of this counter.")
+        .def("save_sorted", &KmerCounter<T>::saveSorted, py::arg("filepath"),
+            py::call_guard<py::gil_scoped_release>(),
+            "Save this counter in sorted format, which can be opened in constant time with `MappedKmerCounter`.")
+
+        .def("__getitem__", py::overload_cast<Kmer const&>(&KmerCounter<T>::query, py::const_))
+        .def("__getitem__", py::overload_cast<char const*>(&KmerCounter<T>::query, py::const_))
 
-        .def("__iter__", [] (KmerCounter& self) {
+        .def("__iter__", [] (KmerCounter<T>& self) {
             return py::make_key_iterator(self.begin(), self.end());
         }, py::keep_alive<0, 1>())
 
-        .def("values", [] (KmerCounter& self) {
+        .def("values", [] (KmerCounter<T>& self) {
             return py::make_value_iterator(self.begin(), self.end());
         }, py::keep_alive<0, 1>())
 
-        .def("items", [] (KmerCounter& self) {
+        .def("items", [] (KmerCounter<T>& self) {
             return py::make_iterator(self.begin(), self.end());
         }, py::keep_alive<0, 1>())
 
-        .def("__len__", [] (KmerCounter const& self) {
+        .def("__len__", [] (KmerCounter<T> const& self) {
             return self.getUniqueKmers();
         })
 
-        .def_property_readonly("num_kmers", &KmerCounter::getNumKmers)
-        .def_property_readonly("num_unique", &KmerCounter::getUniqueKmers)
-        .def_property_readonly("max_count", &KmerCounter::getMaxCount)
+        .def_property_readonly("num_kmers", &KmerCounter<T>::getNumKmers)
+        .def_property_readonly("num_unique", &KmerCounter<T>::getUniqueKmers)
+        .def_property_readonly("max_count", &KmerCounter<T>::getMaxCount)
+        .def_property_readonly("filtered_singletons", &KmerCounter<T>::getFilteredSingletons,
+            "Approximate number of k-mers seen once, kept out of the tables by the singleton filter.")
 
-        .def("save", [] (KmerCounter& self, string const& filepath) {
+        .def("save", [] (KmerCounter<T>& self, string const& filepath) {
             std::ofstream ofile(filepath);
             cereal::BinaryOutputArchive archive(ofile);
 
@@ -270,7 +1237,7 @@ void define_KmerCounter(py::module& m) {
         })
 
         .def_static("from_file", [] (string const& filepath) {
-            KmerCounter kmer_counter;
+            KmerCounter<T> kmer_counter;
 
             std::ifstream ifile(filepath);
             cereal::BinaryInputArchive archive(ifile);
@@ -285,4 +1252,12 @@ void define_KmerCounter(py::module& m) {
     py_KmerCounter.attr("__bases__") = py::make_tuple(Mapping, Set).attr("__add__")(py_KmerCounter.attr("__bases__"));
 }
 
+template class KmerCounter<uint8_t>;
+template class KmerCounter<uint16_t>;
+template class KmerCounter<uint32_t>;
+
+template void define_KmerCounter<uint8_t>(py::module& m, char const* name);
+template void define_KmerCounter<uint16_t>(py::module& m, char const* name);
+template void define_KmerCounter<uint32_t>(py::module& m, char const* name);
+
 }
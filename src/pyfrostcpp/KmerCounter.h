@@ -17,35 +17,33 @@
 
 #include "pyfrost.h"
 #include "Kmer.h"
+#include "KmerCountTable.h"
+#include "KmerBloomFilter.h"
+#include "KmerSpectrum.h"
+#include "FrozenKmerCounter.h"
+#include "MappedKmerCounter.h"
+#include "SequencePipeline.h"
 #include "Serialize.h"
 
-#include <queue>
 #include <thread>
 #include <mutex>
-#include <condition_variable>
-#include <robin_hood.h>
-#include <File_Parser.hpp>
 
 namespace pyfrost {
 
 using std::pair;
 using std::vector;
 
-class KmerCounter;
-
-typedef uint16_t kmercount_t;
-using KmerCountMap = robin_hood::unordered_map<Kmer, kmercount_t>;
-
+template<typename Table>
 class KmerCounterIterator {
 public:
     using iteratory_category = std::input_iterator_tag;
-    using value_type = pair<Kmer, kmercount_t>;
+    using value_type = pair<Kmer, typename Table::count_type>;
     using difference_type = std::ptrdiff_t;
     using reference = value_type&;
     using pointer = value_type*;
 
-    KmerCounterIterator(vector<KmerCountMap>::iterator const& _table_iter,
-        vector<KmerCountMap>::iterator const& _table_end) :
+    KmerCounterIterator(typename vector<Table>::iterator const& _table_iter,
+        typename vector<Table>::iterator const& _table_end) :
         curr_table(_table_iter), table_end(_table_end)
     {
         if(curr_table != table_end) {
@@ -105,7 +103,7 @@ public:
         return make_pair(curr_kmer->first, curr_kmer->second);
     }
 
-    robin_hood::pair<const Kmer, kmercount_t>* operator->() {
+    value_type const* operator->() {
         if(curr_table == table_end) {
             return nullptr;
         }
@@ -126,26 +124,145 @@ public:
     }
 
 private:
-    vector<KmerCountMap>::iterator curr_table;
-    vector<KmerCountMap>::iterator table_end;
-    KmerCountMap::iterator curr_kmer;
-    KmerCountMap::iterator kmer_end;
+    typename vector<Table>::iterator curr_table;
+    typename vector<Table>::iterator table_end;
+    typename Table::const_iterator curr_kmer {nullptr, 0};
+    typename Table::const_iterator kmer_end {nullptr, 0};
+
+};
 
+/**
+ * K-mer counting statistics kept by each counter thread, merged with the shared totals when the thread finishes.
+ */
+struct CounterThreadStats {
+    uint64_t num_kmers = 0;
+    uint64_t num_unique = 0;
+    uint64_t max_count = 0;
+    KmerSpectrum spectrum;
 };
 
+/**
+ * K-mer counter with a hash table per minimizer partition.
+ *
+ * @tparam T Storage type of the per-k-mer counter in the hash tables: uint8_t, uint16_t or uint32_t. With 8-bit
+ *           counters, large counts are kept in a per-table overflow table, see `KmerCountTraits`.
+ */
+template<typename T>
 class KmerCounter {
 public:
+    using table_type = KmerCountTable<T>;
+    using count_type = typename table_type::count_type;
+    using iterator = KmerCounterIterator<table_type>;
+
+    /**
+     * @param num_threads Number of counting threads
+     * @param num_readers Number of threads reading input files. Each reader parses a different file at a time, so
+     *                    this helps when counting many (compressed) files.
+     * @param singleton_filter_bits If non-zero, k-mers are first recorded in a Bloom filter of 2^singleton_filter_bits
+     *                              bits, and only inserted in the hash tables on their second occurrence. This keeps
+     *                              k-mers that occur once (mostly sequencing errors) out of the tables. A false
+     *                              positive in the filter makes a k-mer's count one too high.
+     */
     KmerCounter(size_t k=DEFAULT_K, size_t g=0, bool canonical=true, size_t num_threads=2, size_t table_bits=10,
-        size_t batch_size=100000);
+        size_t batch_size=100000, bool superkmers=true, size_t num_readers=1, size_t singleton_filter_bits=0);
 
     KmerCounter(KmerCounter const& o);
     KmerCounter(KmerCounter&& o);
+    ~KmerCounter();
 
     KmerCounter& countKmersFiles(std::vector<std::string> const& files);
+
+    /**
+     * Count the k-mers of a single sequence on the calling thread. During a streaming session, the sequence is queued
+     * for the worker threads instead.
+     */
     KmerCounter& countKmers(std::string const& str);
 
-    kmercount_t query(char const* qry) const;
-    kmercount_t query(Kmer const& qry) const;
+    /**
+     * Start a streaming session: spawns `num_threads` counter threads that keep counting batches passed to `feed`,
+     * until `finish` is called. Throws if a session is already active.
+     */
+    void start();
+
+    /**
+     * Queue a batch of sequences for counting during a streaming session. Blocks while the queue is full, which is at
+     * `2 * num_threads` batches, so a fast producer can't run ahead of the counter threads. Batches larger than
+     * `batch_size` are split, so they are spread over all threads. Safe to call from multiple threads.
+     */
+    void feed(std::vector<std::string>&& batch);
+
+    /**
+     * End the streaming session: waits until all queued sequences are counted and joins the counter threads.
+     */
+    KmerCounter& finish();
+
+    bool isStreaming() const {
+        return pipeline.isStreaming();
+    }
+
+    /**
+     * Count k-mers in the given files without holding all hash tables in memory at once.
+     *
+     * In a first pass, reads are cut into super-k-mers which are spilled to temporary bucket files on disk, each
+     * bucket holding the super-k-mers of a contiguous range of tables. In the second pass, buckets are counted one
+     * group at a time, where a group holds as many buckets as fit in `max_memory` bytes. After a group is counted its
+     * tables are written to `output_file` and freed again. Bucket files are streamed in blocks, and a bucket that
+     * doesn't fit in `max_memory` by itself is first split into smaller buckets on its range of tables. A single table
+     * isn't split, so use more tables (`table_bits`) if a table exceeds the budget.
+     *
+     * The output file has the same format as `save`, and can be loaded with `KmerCounter.from_file`. This counter
+     * itself only keeps the statistics afterwards; its tables are empty. The singleton filter is not used in this mode.
+     *
+     * @param files FASTA/FASTQ files to count
+     * @param output_file Where to write the resulting k-mer counter
+     * @param tmp_dir Directory for the temporary bucket files, defaults to $TMPDIR or /tmp
+     * @param max_memory Memory budget in bytes for the tables of a single group of buckets
+     * @param num_buckets Number of bucket files, rounded down to a power of two and capped at the number of tables
+     */
+    void countKmersFilesExternal(std::vector<std::string> const& files, std::string const& output_file,
+        std::string const& tmp_dir = "", size_t max_memory = size_t(4) << 30, size_t num_buckets = 64);
+
+    /**
+     * Add all counts of `other` to this counter. Counts saturate at the maximum count of this counter's width. Both
+     * counters should use the same k-mer size, minimizer size and canonical setting.
+     *
+     * If both counters have the same number of tables, tables are merged pairwise in parallel. Otherwise, each k-mer
+     * of `other` is moved to its partition in this counter.
+     */
+    KmerCounter& merge(KmerCounter const& other);
+
+    /**
+     * Merge counters saved with `save` into a single counter. While a file is merged, the next one is read from disk
+     * in the background, so at most one counter and two files besides the result are in memory at once.
+     */
+    static KmerCounter mergeFiles(std::vector<std::string> const& files, size_t num_threads = 2);
+
+    count_type query(char const* qry) const;
+    count_type query(Kmer const& qry) const;
+
+    /**
+     * Query many k-mers at once, split over `num_threads` threads.
+     */
+    std::vector<count_type> queryMany(std::vector<Kmer> const& kmers) const;
+
+    /**
+     * Query many k-mers at once, given as `KMER_WORDS` packed words per k-mer.
+     */
+    std::vector<count_type> queryMany(uint64_t const* words, size_t num_kmers) const;
+
+    /**
+     * Query all k-mers in a sequence. Returns a count for each k-mer position, k-mers with non-ACGT characters get
+     * count 0.
+     */
+    std::vector<count_type> querySequence(std::string const& sequence) const;
+
+    size_t getK() const {
+        return k;
+    }
+
+    size_t getG() const {
+        return g;
+    }
 
     uint64_t getNumKmers() const {
         return num_kmers.load();
@@ -155,16 +272,58 @@ public:
         return num_unique.load();
     }
 
-    kmercount_t getMaxCount() const {
+    count_type getMaxCount() const {
         return max_count.load();
     }
 
-    std::vector<kmercount_t> getAllCounts();
-    std::vector<uint64_t> getFrequencySpectrum();
+    /**
+     * Approximate number of k-mers seen only once, which the singleton filter kept out of the tables. Estimated from
+     * the fill rate of the filter, and zero without a filter.
+     */
+    uint64_t getFilteredSingletons() const;
+
+    /**
+     * Get the counts of all k-mers, in table order. Tables are read in parallel.
+     */
+    std::vector<count_type> getAllCounts() const;
+
+    /**
+     * Export all k-mers with a count in [count_min, count_max] as packed words (`KMER_WORDS` per k-mer), together
+     * with their counts. Tables are exported in parallel.
+     */
+    void exportArrays(count_type count_min, count_type count_max, std::vector<uint64_t>& words,
+                      std::vector<count_type>& counts) const;
+
+    /**
+     * Build a read-only version of this counter, backed by a minimal perfect hash function. Uses a fraction of the
+     * memory of the hash tables, at the cost of a small false positive rate for k-mers that were not counted.
+     */
+    FrozenKmerCounter<T> freeze() const;
+
+    /**
+     * Write this counter in sorted, memory-mappable format. See `MappedKmerCounter` for a description of the format.
+     */
+    void saveSorted(std::string const& filepath) const;
+
+    /**
+     * Write all k-mers with a count of at least `min_count` to a FASTA file. To keep the file small, each record holds
+     * a batch of k-mers separated by an N.
+     *
+     * @return Number of k-mers written
+     */
+    uint64_t writeSolidKmers(std::string const& filepath, count_type min_count) const;
+
+    /**
+     * Get the number of k-mers with each count, where element `i` holds the number of k-mers seen `i + 1` times. The
+     * spectrum is kept up to date while counting, so this doesn't need to walk the tables.
+     */
+    std::vector<uint64_t> getFrequencySpectrum() const;
 
     template<typename Archive>
     void save(Archive& ar) const {
-        ar(k, g, canonical, tables, num_kmers.load(), num_unique.load(), max_count.load());
+        ar(k, g, canonical);
+        save_count_width<T>(ar);
+        ar(tables, num_kmers.load(), num_unique.load(), max_count.load());
     }
 
     template<typename Archive>
@@ -172,49 +331,134 @@ public:
         ar(k, g, canonical);
         setKG(k, g);
 
+        // Counters saved before the count width was recorded have the number of tables in its place
+        cereal::size_type num_tables;
+        if(load_count_width<T>(ar, num_tables)) {
+            ar(cereal::make_size_tag(num_tables));
+        }
+
+        // Same layout as a vector of tables, but the legacy format of the tables also determines the type of the
+        // maximum count
+        tables = std::vector<table_type>(num_tables);
+
+        bool legacy = false;
+        for(auto& table : tables) {
+            legacy = table.loadTable(ar) || legacy;
+        }
+
         size_t _num_kmers = 0;
         size_t _num_unique = 0;
-        kmercount_t _max_count = 0;
-        ar(tables, _num_kmers, _num_unique, _max_count);
+        ar(_num_kmers, _num_unique);
+
+        if(legacy) {
+            LegacyCount _max_count = 0;
+            ar(_max_count);
+            max_count = _max_count;
+        } else {
+            count_type _max_count = 0;
+            ar(_max_count);
+            max_count = _max_count;
+        }
 
         num_kmers = _num_kmers;
         num_unique = _num_unique;
-        max_count = _max_count;
 
-        table_locks = vector<mutex>(tables.size());
+        // Counters saved by older versions partitioned k-mers with Bifrost's minimizers
+        if(!partitionsMatch()) {
+            repartition();
+        }
+
+        rebuildSpectrum();
     }
 
-    KmerCounterIterator begin() {
+    iterator begin() {
         return {tables.begin(), tables.end()};
     }
 
-    KmerCounterIterator end() {
+    iterator end() {
         return {tables.end(), tables.end()};
     }
 
 private:
+    /**
+     * Hash table index of a k-mer, see `minimizerPartition`.
+     */
+    size_t partitionOf(Kmer const& kmer) const {
+        return minimizerPartition(kmer, tables.size());
+    }
+
     void counterThread();
+    void countRead(std::string const& sequence, CounterThreadStats& stats);
+    void countSequence(std::string const& sequence, CounterThreadStats& stats);
+    void countSuperKmers(std::string const& sequence, CounterThreadStats& stats);
+
+    /**
+     * Count a k-mer through the singleton filter: only k-mers already seen before are added to the table.
+     */
+    void countFiltered(Kmer const& kmer, size_t table_ix, CounterThreadStats& stats);
+    void mergeThreadStats(CounterThreadStats const& stats);
+
+    /**
+     * Copy all k-mers and their counts from the hash tables, in table order. Tables are read in parallel.
+     */
+    void collectEntries(std::vector<Kmer>& keys, std::vector<count_type>& counts) const;
+
+    /**
+     * Call `func(table_ix)` for each table, with tables divided dynamically over `num_threads` threads.
+     */
+    template<typename F>
+    void forEachTableParallel(F&& func) const;
+
+    /**
+     * Offset of each table's first entry when all tables are concatenated, with the total as last element.
+     */
+    std::vector<size_t> tableOffsets() const;
+
+    /**
+     * Check whether the first few k-mers of each table are stored in the table `partitionOf` assigns them to.
+     */
+    bool partitionsMatch() const;
+
+    /**
+     * Move all k-mers to the table `partitionOf` assigns them to, for counters saved with a different partitioning.
+     */
+    void repartition();
+
+    /**
+     * Recompute the frequency spectrum from the tables, e.g., after loading a counter from file.
+     */
+    void rebuildSpectrum();
+
+    /**
+     * Set `output[i] = query(get_kmer(i))` for i in [0, n), split over `num_threads` threads.
+     */
+    template<typename F>
+    void queryParallel(size_t n, F&& get_kmer, count_type* output) const;
 
     size_t k;
     size_t g;
     bool canonical;
     size_t num_threads;
     size_t batch_size;
+    bool superkmers;
+    size_t num_readers;
+
+    std::unique_ptr<KmerBloomFilter> singleton_filter;
 
-    std::vector<KmerCountMap> tables;
-    std::vector<std::mutex> table_locks;
+    std::vector<table_type> tables;
     std::atomic<uint64_t> num_kmers;
     std::atomic<uint64_t> num_unique;
-    std::atomic<kmercount_t> max_count;
+    std::atomic<count_type> max_count;
+
+    std::mutex spectrum_lock;
+    KmerSpectrum spectrum;
 
-    std::atomic<bool> finished_reading;
-    std::mutex queue_lock;
-    std::condition_variable sequence_ready;
-    std::queue<std::unique_ptr<std::vector<std::string>>> seq_queue;
+    SequencePipeline pipeline;
 
 };
 
-void define_KmerCounter(py::module& m);
+template<typename T>
+void define_KmerCounter(py::module& m, char const* name);
 
 }
 
@@ -0,0 +1,152 @@
+#include "KmerMPHF.h"
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+using std::vector;
+using std::thread;
+
+namespace pyfrost {
+
+constexpr size_t KmerMPHF::NOT_FOUND;
+constexpr size_t KmerMPHF::MAX_LEVELS;
+constexpr size_t KmerMPHF::WORDS_PER_RANK;
+
+namespace {
+
+/**
+ * Run `func(thread_ix, begin, end)` on `num_threads` contiguous chunks of the range [0, n).
+ */
+template<typename F>
+void parallelChunks(size_t n, size_t num_threads, F&& func) {
+    num_threads = std::max(size_t(1), std::min(num_threads, n));
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
+
+    vector<thread> threads;
+    for(size_t t = 0; t < num_threads; ++t) {
+        size_t begin = std::min(n, t * chunk_size);
+        size_t end = std::min(n, begin + chunk_size);
+
+        threads.emplace_back([&func, t, begin, end] () { func(t, begin, end); });
+    }
+
+    for(auto& t : threads) {
+        t.join();
+    }
+}
+
+}
+
+KmerMPHF::KmerMPHF(vector<Kmer> const& keys, size_t num_threads, double gamma) : num_keys(keys.size())
+{
+    level_offsets.push_back(0);
+
+    // Only k-mers that collide at a level are copied, the first level reads straight from `keys`
+    vector<Kmer> remaining;
+    vector<Kmer> const* level_keys = &keys;
+
+    for(size_t level = 0; level < MAX_LEVELS && !level_keys->empty(); ++level) {
+        size_t num_words = std::max(size_t(1), static_cast<size_t>(gamma * level_keys->size() / 64.0) + 1);
+        uint64_t level_bits = num_words * 64;
+
+        vector<std::atomic<uint64_t>> seen(num_words);
+        vector<std::atomic<uint64_t>> collisions(num_words);
+        for(size_t i = 0; i < num_words; ++i) {
+            seen[i].store(0, std::memory_order_relaxed);
+            collisions[i].store(0, std::memory_order_relaxed);
+        }
+
+        parallelChunks(level_keys->size(), num_threads, [&] (size_t, size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i) {
+                uint64_t pos = levelHash((*level_keys)[i], level, level_bits);
+                uint64_t mask = uint64_t(1) << (pos % 64);
+
+                if(seen[pos / 64].fetch_or(mask, std::memory_order_relaxed) & mask) {
+                    collisions[pos / 64].fetch_or(mask, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        size_t level_start = bits.size();
+        bits.resize(level_start + num_words);
+        for(size_t i = 0; i < num_words; ++i) {
+            bits[level_start + i] = seen[i].load(std::memory_order_relaxed)
+                & ~collisions[i].load(std::memory_order_relaxed);
+        }
+
+        level_offsets.push_back(level_offsets.back() + level_bits);
+
+        // Collect the k-mers for the next level
+        vector<vector<Kmer>> thread_collided(std::max(size_t(1), num_threads));
+        parallelChunks(level_keys->size(), num_threads, [&] (size_t t, size_t begin, size_t end) {
+            for(size_t i = begin; i < end; ++i) {
+                uint64_t pos = levelHash((*level_keys)[i], level, level_bits);
+                if(collisions[pos / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (pos % 64))) {
+                    thread_collided[t].push_back((*level_keys)[i]);
+                }
+            }
+        });
+
+        vector<Kmer> collided;
+        for(auto& v : thread_collided) {
+            collided.insert(collided.end(), v.begin(), v.end());
+        }
+
+        remaining = std::move(collided);
+        level_keys = &remaining;
+    }
+
+    ranks.reserve(bits.size() / WORDS_PER_RANK + 1);
+    uint64_t num_set = 0;
+    for(size_t i = 0; i < bits.size(); ++i) {
+        if(i % WORDS_PER_RANK == 0) {
+            ranks.push_back(num_set);
+        }
+
+        num_set += __builtin_popcountll(bits[i]);
+    }
+
+    for(auto const& kmer : *level_keys) {
+        fallback.emplace(kmer, num_set++);
+    }
+}
+
+uint64_t KmerMPHF::levelHash(Kmer const& kmer, size_t level, uint64_t level_bits)
+{
+    uint64_t h = kmer.hash(0x9E3779B97F4A7C15ULL * (level + 1));
+
+    // Map the hash to [0, level_bits) without a division
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(h) * level_bits) >> 64);
+}
+
+size_t KmerMPHF::rank(uint64_t pos) const
+{
+    size_t word = pos / 64;
+    size_t block = word / WORDS_PER_RANK;
+
+    uint64_t r = ranks[block];
+    for(size_t i = block * WORDS_PER_RANK; i < word; ++i) {
+        r += __builtin_popcountll(bits[i]);
+    }
+
+    uint64_t mask = (uint64_t(1) << (pos % 64)) - 1;
+    return r + __builtin_popcountll(bits[word] & mask);
+}
+
+size_t KmerMPHF::lookup(Kmer const& kmer) const
+{
+    for(size_t level = 0; level + 1 < level_offsets.size(); ++level) {
+        uint64_t level_bits = level_offsets[level + 1] - level_offsets[level];
+        uint64_t pos = level_offsets[level] + levelHash(kmer, level, level_bits);
+
+        if(bits[pos / 64] & (uint64_t(1) << (pos % 64))) {
+            return rank(pos);
+        }
+    }
+
+    auto it = fallback.find(kmer);
+    return it != fallback.end() ? it->second : NOT_FOUND;
+}
+
+}
@@ -0,0 +1,85 @@
+/**
+ * Minimal perfect hash function over a fixed set of k-mers.
+ *
+ * Follows the construction of BBHash: at each level, every remaining k-mer is hashed to a bit array of
+ * `gamma * num_remaining` bits. K-mers that land on a bit no other k-mer maps to keep that bit, the others move on to
+ * the next level. The index of a k-mer is the rank of its bit in the concatenation of all levels. The few k-mers that
+ * still collide after the last level are stored in a small fallback map.
+ *
+ * Limasset, Antoine, et al. "Fast and scalable minimal perfect hashing for massive key sets." SEA 2017.
+ */
+
+#ifndef PYFROST_KMERMPHF_H
+#define PYFROST_KMERMPHF_H
+
+#include "Kmer.h"
+#include "Serialize.h"
+
+#include <vector>
+#include <limits>
+#include <robin_hood.h>
+#include <cereal/types/vector.hpp>
+
+namespace pyfrost {
+
+class KmerMPHF {
+public:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    KmerMPHF() : num_keys(0) { }
+
+    /**
+     * Build the perfect hash function for the given set of unique k-mers.
+     *
+     * @param keys Unique k-mers
+     * @param num_threads Number of threads to use during construction
+     * @param gamma Bits per remaining k-mer at each level, trades memory for construction and lookup speed
+     */
+    explicit KmerMPHF(std::vector<Kmer> const& keys, size_t num_threads = 1, double gamma = 2.0);
+
+    KmerMPHF(KmerMPHF const& o) = default;
+    KmerMPHF(KmerMPHF&& o) = default;
+    KmerMPHF& operator=(KmerMPHF const& o) = default;
+    KmerMPHF& operator=(KmerMPHF&& o) = default;
+
+    /**
+     * Get the index of a k-mer in [0, size()). K-mers that were not in the construction set either map to an
+     * arbitrary index or to `NOT_FOUND`.
+     */
+    size_t lookup(Kmer const& kmer) const;
+
+    size_t size() const {
+        return num_keys;
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar) {
+        ar(num_keys, bits, level_offsets, ranks, fallback);
+    }
+
+private:
+    static constexpr size_t MAX_LEVELS = 32;
+    static constexpr size_t WORDS_PER_RANK = 8;
+
+    static uint64_t levelHash(Kmer const& kmer, size_t level, uint64_t level_bits);
+
+    size_t rank(uint64_t pos) const;
+
+    size_t num_keys;
+
+    /// Bit arrays of all levels concatenated
+    std::vector<uint64_t> bits;
+
+    /// Bit offset of each level in `bits`, with the end of the last level as last element
+    std::vector<uint64_t> level_offsets;
+
+    /// Number of set bits before each block of `WORDS_PER_RANK` words
+    std::vector<uint64_t> ranks;
+
+    /// K-mers that couldn't be placed in any level
+    robin_hood::unordered_map<Kmer, uint64_t> fallback;
+};
+
+}
+
+#endif //PYFROST_KMERMPHF_H
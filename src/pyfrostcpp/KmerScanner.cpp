@@ -0,0 +1,305 @@
+#include "KmerScanner.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PYFROST_HAS_AVX2_KERNEL
+#endif
+
+namespace pyfrost {
+
+namespace {
+
+char const BASE_CHARS[4] = {'A', 'C', 'G', 'T'};
+
+std::array<uint8_t, 256> makeBaseCodes() {
+    std::array<uint8_t, 256> codes;
+    codes.fill(static_cast<uint8_t>(KmerScanner::INVALID_BASE));
+
+    codes['A'] = codes['a'] = 0;
+    codes['C'] = codes['c'] = 1;
+    codes['G'] = codes['g'] = 2;
+    codes['T'] = codes['t'] = 3;
+
+    return codes;
+}
+
+void encodeBasesScalar(char const* seq, size_t len, uint8_t* out) {
+    static std::array<uint8_t, 256> const codes = makeBaseCodes();
+
+    for(size_t i = 0; i < len; ++i) {
+        out[i] = codes[static_cast<unsigned char>(seq[i])];
+    }
+}
+
+#ifdef PYFROST_HAS_AVX2_KERNEL
+__attribute__((target("avx2")))
+void encodeBasesAVX2(char const* seq, size_t len, uint8_t* out) {
+    __m256i const case_bit = _mm256_set1_epi8(0x20);
+    __m256i const lower_a = _mm256_set1_epi8('a');
+    __m256i const lower_c = _mm256_set1_epi8('c');
+    __m256i const lower_g = _mm256_set1_epi8('g');
+    __m256i const lower_t = _mm256_set1_epi8('t');
+    __m256i const low_bits = _mm256_set1_epi8(3);
+    __m256i const low_bit = _mm256_set1_epi8(1);
+    __m256i const invalid = _mm256_set1_epi8(KmerScanner::INVALID_BASE);
+
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(seq + i));
+        __m256i lower = _mm256_or_si256(chars, case_bit);
+        __m256i valid = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, lower_a), _mm256_cmpeq_epi8(lower, lower_c)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(lower, lower_g), _mm256_cmpeq_epi8(lower, lower_t)));
+
+        // Bits 1-2 of the ASCII code give A = 0, C = 1, T = 2, G = 3, and x ^ (x >> 1) swaps G and T. There's no
+        // 8-bit shift, but the mask drops the bits shifted in from the neighbouring byte.
+        __m256i x = _mm256_and_si256(_mm256_srli_epi16(chars, 1), low_bits);
+        __m256i code = _mm256_xor_si256(x, _mm256_and_si256(_mm256_srli_epi16(x, 1), low_bit));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_blendv_epi8(invalid, code, valid));
+    }
+
+    encodeBasesScalar(seq + i, len - i, out + i);
+}
+#endif
+
+using EncodeFunc = void (*)(char const*, size_t, uint8_t*);
+
+bool avx2Supported() {
+#if defined(__AVX2__)
+    // Built with COMPILATION_ARCH targeting an AVX2 capable CPU, no need for a runtime check
+    return true;
+#elif defined(PYFROST_HAS_AVX2_KERNEL)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+EncodeFunc selectEncoder() {
+#ifdef PYFROST_HAS_AVX2_KERNEL
+    return avx2Supported() ? encodeBasesAVX2 : encodeBasesScalar;
+#else
+    return encodeBasesScalar;
+#endif
+}
+
+std::atomic<EncodeFunc>& currentEncoder() {
+    static std::atomic<EncodeFunc> encoder(selectEncoder());
+    return encoder;
+}
+
+/**
+ * Finalizer of MurmurHash3, to spread the bits of a packed g-mer over the whole hash.
+ */
+inline uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+inline uint64_t mixHash(unsigned __int128 h) {
+    return mixHash(static_cast<uint64_t>(h) ^ mixHash(static_cast<uint64_t>(h >> 64)));
+}
+
+/**
+ * Smallest canonical g-mer hash of a k-mer, rolling the g-mers over the 2-bit packed words of the k-mer: base `i` is
+ * stored in word i / 32, starting from the most significant bits.
+ */
+template<typename Word>
+uint64_t packedMinimizerHash(Kmer const& kmer) {
+    size_t const k = Kmer::k;
+    size_t const g = Minimizer::g;
+    size_t const gmer_bits = 2 * g;
+    Word const gmer_mask = gmer_bits >= 8 * sizeof(Word) ? ~Word(0) : (Word(1) << gmer_bits) - 1;
+
+    uint64_t words[KMER_WORDS];
+    kmer_to_words(kmer, words);
+
+    Word fw_gmer = 0;
+    Word bw_gmer = 0;
+    uint64_t min_hash = std::numeric_limits<uint64_t>::max();
+    for(size_t i = 0; i < k; ++i) {
+        auto base = static_cast<uint8_t>((words[i / 32] >> (62 - 2 * (i % 32))) & 3);
+
+        fw_gmer = ((fw_gmer << 2) | base) & gmer_mask;
+        bw_gmer = (bw_gmer >> 2) | (Word(3 - base) << (gmer_bits - 2));
+
+        if(i + 1 >= g) {
+            min_hash = std::min(min_hash, mixHash(std::min(fw_gmer, bw_gmer)));
+        }
+    }
+
+    return min_hash;
+}
+
+}
+
+void encodeBases(char const* seq, size_t len, uint8_t* out)
+{
+    currentEncoder().load(std::memory_order_relaxed)(seq, len, out);
+}
+
+bool setBaseEncoder(BaseEncoder encoder)
+{
+    switch(encoder) {
+        case BaseEncoder::AUTO:
+            currentEncoder() = selectEncoder();
+            return true;
+
+        case BaseEncoder::SCALAR:
+            currentEncoder() = encodeBasesScalar;
+            return true;
+
+        case BaseEncoder::AVX2:
+#ifdef PYFROST_HAS_AVX2_KERNEL
+            if(avx2Supported()) {
+                currentEncoder() = encodeBasesAVX2;
+                return true;
+            }
+#endif
+            return false;
+    }
+
+    return false;
+}
+
+uint64_t kmerMinimizerHash(Kmer const& kmer)
+{
+    // Same word width as `KmerScanner::scan`, so both compute the same hash
+    if(Minimizer::g > 32) {
+        return packedMinimizerHash<unsigned __int128>(kmer);
+    } else {
+        return packedMinimizerHash<uint64_t>(kmer);
+    }
+}
+
+size_t KmerScanner::scan(char const* seq, size_t len, bool canonical, bool minimizers)
+{
+    kmers.clear();
+    positions.clear();
+    minimizer_hashes.clear();
+
+    if(len < Kmer::k) {
+        return 0;
+    }
+
+    bases.resize(len);
+    encodeBases(seq, len, bases.data());
+
+    // Packed g-mers need 2g bits
+    if(minimizers && Minimizer::g > 32) {
+        scanBases<unsigned __int128>(len, canonical, minimizers);
+    } else {
+        scanBases<uint64_t>(len, canonical, minimizers);
+    }
+
+    return kmers.size();
+}
+
+template<typename Word>
+void KmerScanner::scanBases(size_t len, bool canonical, bool minimizers)
+{
+    size_t const k = Kmer::k;
+    size_t const g = Minimizer::g;
+    size_t const gmer_bits = 2 * g;
+    Word const gmer_mask = gmer_bits >= 8 * sizeof(Word) ? ~Word(0) : (Word(1) << gmer_bits) - 1;
+
+    kmers.reserve(len - k + 1);
+    positions.reserve(len - k + 1);
+    if(minimizers) {
+        minimizer_hashes.reserve(len - k + 1);
+        gmer_hashes.resize(len);
+        window.clear();
+    }
+
+    Kmer fw, bw;
+    Word fw_gmer = 0;
+    Word bw_gmer = 0;
+    size_t window_head = 0;
+    size_t run = 0;
+    char init_buf[MAX_KMER_SIZE + 1];
+
+    for(size_t i = 0; i < len; ++i) {
+        uint8_t base = bases[i];
+        if(base == INVALID_BASE) {
+            run = 0;
+            window.clear();
+            window_head = 0;
+            continue;
+        }
+
+        ++run;
+
+        if(minimizers) {
+            fw_gmer = ((fw_gmer << 2) | base) & gmer_mask;
+            bw_gmer = (bw_gmer >> 2) | (Word(3 - base) << (gmer_bits - 2));
+
+            if(run >= g) {
+                gmer_hashes[i] = mixHash(std::min(fw_gmer, bw_gmer));
+
+                // Keep the window's g-mer hashes increasing from head to tail, a g-mer with a larger hash than a
+                // newer one can never be the minimum again
+                while(window.size() > window_head && gmer_hashes[window.back()] >= gmer_hashes[i]) {
+                    window.pop_back();
+                }
+
+                window.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        if(run < k) {
+            continue;
+        }
+
+        size_t start = i + 1 - k;
+        if(run == k) {
+            // First k-mer after the start of the sequence or after a non-ACGT character
+            for(size_t j = 0; j < k; ++j) {
+                init_buf[j] = BASE_CHARS[bases[start + j]];
+            }
+
+            init_buf[k] = '\0';
+            fw = Kmer(init_buf);
+            bw = fw.twin();
+        } else {
+            fw.selfForwardBase(BASE_CHARS[base]);
+            bw = bw.backwardBase(BASE_CHARS[3 - base]);
+        }
+
+        kmers.push_back(canonical && bw < fw ? bw : fw);
+        positions.push_back(static_cast<uint32_t>(start));
+
+        if(minimizers) {
+            // Drop g-mers that start before this k-mer, i.e., end before position start + g - 1
+            while(window[window_head] + 1 < start + g) {
+                ++window_head;
+            }
+
+            minimizer_hashes.push_back(gmer_hashes[window[window_head]]);
+        }
+    }
+}
+
+void define_KmerScanner(py::module& m) {
+    py::enum_<BaseEncoder>(m, "BaseEncoder", py::module_local())
+        .value("AUTO", BaseEncoder::AUTO)
+        .value("SCALAR", BaseEncoder::SCALAR)
+        .value("AVX2", BaseEncoder::AVX2);
+
+    m.def("set_base_encoder", &setBaseEncoder, py::arg("encoder"),
+          "Force the implementation used to encode sequences when extracting k-mers and minimizers. Returns False if "
+          "it isn't supported by this CPU.");
+}
+
+}
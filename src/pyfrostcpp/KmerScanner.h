@@ -0,0 +1,116 @@
+/**
+ * Fused k-mer and minimizer extraction.
+ *
+ * Walking a read with `KmerIterator` and a separate `minHashIterator` parses the read twice, with a branch on
+ * non-ACGT characters for every base in both. `KmerScanner` instead 2-bit encodes the whole read in a single pass
+ * (with AVX2 when the CPU supports it), and then rolls the forward k-mer, its reverse complement and the minimizer hash
+ * together over the encoded bases.
+ *
+ * The minimizer of a k-mer is the smallest hash among its canonical g-mers. Canonical g-mers don't depend on the
+ * strand, so a k-mer and its reverse complement have the same minimizer hash, and the hash only depends on the k-mer
+ * itself. This makes it suitable to assign k-mers to partitions, see `minimizerPartition`.
+ */
+
+#ifndef PYFROST_KMERSCANNER_H
+#define PYFROST_KMERSCANNER_H
+
+#include "Kmer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pyfrost {
+
+/**
+ * 2-bit encode a sequence: A = 0, C = 1, G = 2, T = 3 (case insensitive), and 4 for any other character. Uses AVX2
+ * when compiled for it or when the CPU supports it at runtime, and a lookup table otherwise.
+ */
+void encodeBases(char const* seq, size_t len, uint8_t* out);
+
+/**
+ * Implementation used by `encodeBases`. `AUTO` picks AVX2 if the CPU supports it.
+ */
+enum class BaseEncoder {
+    AUTO,
+    SCALAR,
+    AVX2
+};
+
+/**
+ * Force the implementation used by `encodeBases`, e.g., to check that all implementations give the same k-mers. Returns
+ * false and keeps the current implementation if the requested one isn't available on this CPU.
+ */
+bool setBaseEncoder(BaseEncoder encoder);
+
+/**
+ * Minimizer hash of a single k-mer, computed directly from its packed bases. Equals `KmerScanner::minimizerHash` for
+ * that k-mer (or its reverse complement) in any sequence.
+ */
+uint64_t kmerMinimizerHash(Kmer const& kmer);
+
+class KmerScanner {
+public:
+    static constexpr uint8_t INVALID_BASE = 4;
+
+    /**
+     * Extract all k-mers of `seq` that only contain ACGT characters.
+     *
+     * @param canonical Output the canonical k-mer instead of the k-mer as it appears in the sequence
+     * @param minimizers Also compute the minimizer hash of each k-mer
+     * @return Number of k-mers found
+     */
+    size_t scan(char const* seq, size_t len, bool canonical, bool minimizers);
+
+    size_t scan(std::string const& seq, bool canonical, bool minimizers) {
+        return scan(seq.c_str(), seq.size(), canonical, minimizers);
+    }
+
+    size_t size() const {
+        return kmers.size();
+    }
+
+    Kmer const& kmer(size_t i) const {
+        return kmers[i];
+    }
+
+    /**
+     * Position of the i-th k-mer in the sequence.
+     */
+    size_t position(size_t i) const {
+        return positions[i];
+    }
+
+    /**
+     * Minimizer hash of the i-th k-mer, only available if the last scan computed minimizers.
+     */
+    uint64_t minimizerHash(size_t i) const {
+        return minimizer_hashes[i];
+    }
+
+    std::vector<Kmer> const& getKmers() const {
+        return kmers;
+    }
+
+private:
+    /**
+     * Roll k-mers and minimizers over the encoded bases, with packed g-mers stored in `Word`.
+     */
+    template<typename Word>
+    void scanBases(size_t len, bool canonical, bool minimizers);
+
+    std::vector<uint8_t> bases;
+    std::vector<Kmer> kmers;
+    std::vector<uint32_t> positions;
+    std::vector<uint64_t> minimizer_hashes;
+
+    // Hash of each g-mer ending at a base, and the sliding window minimum queue of g-mer end positions
+    std::vector<uint64_t> gmer_hashes;
+    std::vector<uint32_t> window;
+};
+
+void define_KmerScanner(py::module& m);
+
+}
+
+#endif //PYFROST_KMERSCANNER_H
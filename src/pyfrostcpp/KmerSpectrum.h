@@ -0,0 +1,95 @@
+/**
+ * A k-mer frequency spectrum that is kept up to date while counting.
+ *
+ * Counter threads each record count changes in their own `KmerSpectrum`, which are added to the shared spectrum when
+ * a thread finishes. A thread can see a k-mer go from count 3 to 4 that another thread inserted, so the per-thread
+ * values are deltas that can be negative; only the merged spectrum is guaranteed to be non-negative.
+ *
+ * Low counts, which hold almost all k-mers, are kept in a dense array. The long tail of high counts is kept in a
+ * hash map, so a few very abundant k-mers don't blow up the size of every per-thread histogram.
+ */
+
+#ifndef PYFROST_KMERSPECTRUM_H
+#define PYFROST_KMERSPECTRUM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <robin_hood.h>
+
+namespace pyfrost {
+
+class KmerSpectrum {
+public:
+    /**
+     * Record that a k-mer went from `old_count` to `new_count`. An old count of zero means the k-mer is new.
+     */
+    void update(uint64_t old_count, uint64_t new_count) {
+        if(old_count > 0) {
+            add(old_count, -1);
+        }
+
+        add(new_count, 1);
+    }
+
+    void add(uint64_t count, int64_t num_kmers) {
+        if(count < DENSE_LIMIT) {
+            if(count >= dense.size()) {
+                dense.resize(count + 1, 0);
+            }
+
+            dense[count] += num_kmers;
+        } else {
+            sparse[count] += num_kmers;
+        }
+    }
+
+    void merge(KmerSpectrum const& o) {
+        if(o.dense.size() > dense.size()) {
+            dense.resize(o.dense.size(), 0);
+        }
+
+        for(size_t count = 0; count < o.dense.size(); ++count) {
+            dense[count] += o.dense[count];
+        }
+
+        for(auto const& e : o.sparse) {
+            sparse[e.first] += e.second;
+        }
+    }
+
+    void clear() {
+        dense.clear();
+        sparse.clear();
+    }
+
+    /**
+     * Get the spectrum as a vector where element `i` holds the number of k-mers with count `i + 1`, for counts up to
+     * and including `max_count`.
+     */
+    std::vector<uint64_t> toVector(uint64_t max_count) const {
+        std::vector<uint64_t> spectrum(max_count, 0);
+
+        for(size_t count = 1; count < dense.size() && count <= max_count; ++count) {
+            spectrum[count - 1] = static_cast<uint64_t>(std::max<int64_t>(0, dense[count]));
+        }
+
+        for(auto const& e : sparse) {
+            if(e.first <= max_count && e.second > 0) {
+                spectrum[e.first - 1] = static_cast<uint64_t>(e.second);
+            }
+        }
+
+        return spectrum;
+    }
+
+private:
+    static constexpr uint64_t DENSE_LIMIT = 4096;
+
+    std::vector<int64_t> dense;
+    robin_hood::unordered_map<uint64_t, int64_t> sparse;
+};
+
+}
+
+#endif //PYFROST_KMERSPECTRUM_H
@@ -4,7 +4,7 @@
 namespace pyfrost {
 
 void define_LinkAnnotator(py::module& m) {
-    py::class_<LinkAnnotator<PyfrostCCDBG>>(m, "LinkAnnotator")
+    py::class_<LinkAnnotator<PyfrostCCDBG>>(m, "LinkAnnotator", py::module_local())
         .def(py::init<PyfrostCCDBG*, LinkDB*>())
         .def_property("max_link_length",
                       &LinkAnnotator<PyfrostCCDBG>::getMaxLinkLength, &LinkAnnotator<PyfrostCCDBG>::setMaxLinkLength)
@@ -13,14 +13,15 @@ void define_LinkAnnotator(py::module& m) {
              py::arg("sequence"), py::arg("keep_nodes") = false)
          .def("add_links_from_path", &LinkAnnotator<PyfrostCCDBG>::addLinksFromPath);
 
-    py::class_<ColorAssociatedAnnotator<PyfrostCCDBG>, LinkAnnotator<PyfrostCCDBG>>(m, "ColorAssociatedAnnotator")
+    py::class_<ColorAssociatedAnnotator<PyfrostCCDBG>, LinkAnnotator<PyfrostCCDBG>>(m, "ColorAssociatedAnnotator",
+                                                                                    py::module_local())
         .def(py::init<PyfrostCCDBG*, LinkDB*>());
 
     m.def("add_links_from_fasta", &addLinksFromFasta<PyfrostCCDBG>, py::call_guard<py::gil_scoped_release>());
 }
 
 void define_MappingResult(py::module& m) {
-    py::class_<MappingResult>(m, "MappingResult")
+    py::class_<MappingResult>(m, "MappingResult", py::module_local())
         .def_readonly("paths", &MappingResult::paths)
         .def("start_unitig", &MappingResult::start_unitig)
         .def("end_unitig", &MappingResult::end_unitig)
@@ -5,6 +5,7 @@
 #include "JunctionTree.h"
 #include "LinkDB.h"
 #include "Neighbors.h"
+#include "KmerScanner.h"
 
 #include <condition_variable>
 #include <algorithm>
@@ -178,6 +179,9 @@ protected:
     LinkDB* db;
     size_t max_link_length;
     std::deque<std::pair<size_t, JunctionTreeNode*>> nodes_to_annotate;
+
+    // Reused between sequences to avoid reallocating its buffers
+    KmerScanner scanner;
 };
 
 template<typename T>
@@ -218,12 +222,11 @@ MappingResult LinkAnnotator<T>::addLinksFromSequence(string const& seq, bool kee
 
     vector<typename T::unitigmap_t> successors;
 
-    KmerIterator kmer_iter(seq.c_str()), kmer_end;
+    size_t num_kmers = scanner.scan(seq, false, false);
     vector<Kmer> curr_path;
-    for(; kmer_iter != kmer_end; ++kmer_iter) {
-        Kmer kmer;
-        size_t pos;
-        tie(kmer, pos) = *kmer_iter;
+    for(size_t kmer_ix = 0; kmer_ix < num_kmers; ++kmer_ix) {
+        Kmer kmer = scanner.kmer(kmer_ix);
+        size_t pos = scanner.position(kmer_ix);
 
         auto umap = findKmer(kmer);
         if(umap.isEmpty) {
@@ -295,14 +298,15 @@ MappingResult LinkAnnotator<T>::addLinksFromSequence(string const& seq, bool kee
         size_t oriented_pos = kmerPosOriented(umap);
         size_t diff_to_unitig_end = unitig_len - oriented_pos - 1;
 
-        for(int i = 0; i < diff_to_unitig_end && kmer_iter != kmer_end; ++i) {
+        for(int i = 0; i < diff_to_unitig_end && kmer_ix < num_kmers; ++i) {
             // To error correct reads, we don't care if the kmers of the unitig don't match the k-mers of the given
             // sequence, as long as it ends up on the same unitig again (see code below for loop). We do keep track
             // of mismatches for analysis purposes.
-            ++kmer_iter;
+            ++kmer_ix;
 
-            if(kmer_iter != kmer_end) {
-                tie(kmer, pos) = *kmer_iter;
+            if(kmer_ix < num_kmers) {
+                kmer = scanner.kmer(kmer_ix);
+                pos = scanner.position(kmer_ix);
 
                 size_t unitig_pos = umap.dist + (umap.strand ? i + 1 : -i - 1);
                 unitig_kmer = unitig.getMappedKmer(unitig_pos);
@@ -314,7 +318,7 @@ MappingResult LinkAnnotator<T>::addLinksFromSequence(string const& seq, bool kee
             }
         }
 
-        if(kmer_iter == kmer_end) {
+        if(kmer_ix == num_kmers) {
             // End of sequence, but still on the same unitig, so no branches encountered
             break;
         }
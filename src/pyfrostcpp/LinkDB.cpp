@@ -4,7 +4,7 @@ namespace pyfrost {
 
 void define_LinkDB(py::module& m) {
     // Simple abstract class
-    py::class_<LinkDB>(m, "LinkDB")
+    py::class_<LinkDB>(m, "LinkDB", py::module_local())
         .def("merge", &LinkDB::merge)
         .def_property(
             "color", [] (LinkDB& self) -> py::object {
@@ -0,0 +1,376 @@
+#include "MappedKmerCounter.h"
+
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::vector;
+using std::string;
+using std::thread;
+
+namespace pyfrost {
+
+constexpr char MappedKmerCounterHeader::MAGIC[8];
+constexpr uint32_t MappedKmerCounterHeader::VERSION;
+
+namespace {
+
+constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+/// Largest prefix index, 2^28 groups take 2 GB
+constexpr uint32_t MAX_PREFIX_BITS = 28;
+
+/// Targeted average number of k-mers per prefix group
+constexpr uint64_t KMERS_PER_GROUP = 16;
+
+uint64_t alignOffset(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+/**
+ * Compare two k-mers on their packed words, returns a negative value, zero or a positive value like `memcmp`.
+ */
+int compareWords(uint64_t const* a, uint64_t const* b) {
+    for(size_t w = 0; w < KMER_WORDS; ++w) {
+        if(a[w] != b[w]) {
+            return a[w] < b[w] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+void writePadding(std::ofstream& ofile, uint64_t offset) {
+    static char const zeros[SECTION_ALIGNMENT] = {};
+    ofile.write(zeros, alignOffset(offset) - offset);
+}
+
+}
+
+template<typename C>
+void MappedKmerCounter::write(string const& filepath, size_t k, size_t g, bool canonical, vector<Kmer> const& keys,
+                              vector<C> const& counts, uint64_t num_kmers, uint64_t max_count, size_t num_threads)
+{
+    uint64_t num_entries = keys.size();
+    num_threads = std::max(size_t(1), num_threads);
+
+    uint32_t prefix_bits = 0;
+    while(prefix_bits < MAX_PREFIX_BITS && (KMERS_PER_GROUP << (prefix_bits + 1)) <= num_entries) {
+        ++prefix_bits;
+    }
+
+    uint64_t num_groups = uint64_t(1) << prefix_bits;
+
+    // Counting sort on prefix, followed by sorting each group on the packed k-mer words
+    vector<uint32_t> prefixes(num_entries);
+    vector<uint64_t> index(num_groups + 1, 0);
+    {
+        size_t chunk_size = (num_entries + num_threads - 1) / num_threads;
+        vector<thread> threads;
+        for(size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] () {
+                size_t end = std::min(num_entries, (t + 1) * chunk_size);
+                for(size_t i = t * chunk_size; i < end; ++i) {
+                    prefixes[i] = static_cast<uint32_t>(prefixOf(keys[i], prefix_bits));
+                }
+            });
+        }
+
+        for(auto& t : threads) {
+            t.join();
+        }
+    }
+
+    for(auto prefix : prefixes) {
+        ++index[prefix + 1];
+    }
+
+    for(size_t i = 0; i < num_groups; ++i) {
+        index[i + 1] += index[i];
+    }
+
+    vector<uint64_t> order(num_entries);
+    {
+        vector<uint64_t> next(index.begin(), index.end() - 1);
+        for(size_t i = 0; i < num_entries; ++i) {
+            order[next[prefixes[i]]++] = i;
+        }
+    }
+
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    {
+        size_t chunk_size = (num_groups + num_threads - 1) / num_threads;
+        vector<thread> threads;
+        for(size_t t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] () {
+                size_t end = std::min(num_groups, (t + 1) * chunk_size);
+                for(size_t group = t * chunk_size; group < end; ++group) {
+                    std::sort(order.begin() + index[group], order.begin() + index[group + 1],
+                              [&keys] (uint64_t a, uint64_t b) {
+                        uint64_t words_a[KMER_WORDS];
+                        uint64_t words_b[KMER_WORDS];
+                        kmer_to_words(keys[a], words_a);
+                        kmer_to_words(keys[b], words_b);
+
+                        return compareWords(words_a, words_b) < 0;
+                    });
+                }
+            });
+        }
+
+        for(auto& t : threads) {
+            t.join();
+        }
+    }
+
+    MappedKmerCounterHeader header = {};
+    std::copy(std::begin(MappedKmerCounterHeader::MAGIC), std::end(MappedKmerCounterHeader::MAGIC), header.magic);
+    header.version = MappedKmerCounterHeader::VERSION;
+    header.k = static_cast<uint32_t>(k);
+    header.g = static_cast<uint32_t>(g);
+    header.canonical = canonical;
+    header.kmer_words = KMER_WORDS;
+    header.count_bytes = max_count <= UINT8_MAX ? 1 : (max_count <= UINT16_MAX ? 2 : 4);
+    header.prefix_bits = prefix_bits;
+    header.num_entries = num_entries;
+    header.num_kmers = num_kmers;
+    header.max_count = max_count;
+
+    header.index_offset = alignOffset(sizeof(MappedKmerCounterHeader));
+    header.kmers_offset = alignOffset(header.index_offset + index.size() * sizeof(uint64_t));
+    header.counts_offset = alignOffset(header.kmers_offset + num_entries * KMER_WORDS * sizeof(uint64_t));
+
+    std::ofstream ofile(filepath, std::ios::binary);
+    if(!ofile) {
+        throw std::runtime_error("Could not open " + filepath + " for writing.");
+    }
+
+    ofile.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    writePadding(ofile, sizeof(header));
+
+    ofile.write(reinterpret_cast<char const*>(index.data()), index.size() * sizeof(uint64_t));
+    writePadding(ofile, header.index_offset + index.size() * sizeof(uint64_t));
+
+    // Write k-mers and counts in chunks, to avoid another copy of all k-mers in memory
+    size_t const chunk_size = 65536;
+    vector<uint64_t> words_buffer(chunk_size * KMER_WORDS);
+    for(size_t begin = 0; begin < num_entries; begin += chunk_size) {
+        size_t end = std::min(num_entries, begin + chunk_size);
+        for(size_t i = begin; i < end; ++i) {
+            kmer_to_words(keys[order[i]], &words_buffer[(i - begin) * KMER_WORDS]);
+        }
+
+        ofile.write(reinterpret_cast<char const*>(words_buffer.data()), (end - begin) * KMER_WORDS * sizeof(uint64_t));
+    }
+
+    writePadding(ofile, header.kmers_offset + num_entries * KMER_WORDS * sizeof(uint64_t));
+
+    vector<unsigned char> counts_buffer(chunk_size * header.count_bytes);
+    for(size_t begin = 0; begin < num_entries; begin += chunk_size) {
+        size_t end = std::min(num_entries, begin + chunk_size);
+        for(size_t i = begin; i < end; ++i) {
+            unsigned char* dest = &counts_buffer[(i - begin) * header.count_bytes];
+            auto count = static_cast<uint32_t>(counts[order[i]]);
+
+            if(header.count_bytes == 1) {
+                *dest = static_cast<uint8_t>(count);
+            } else if(header.count_bytes == 2) {
+                auto count16 = static_cast<uint16_t>(count);
+                std::memcpy(dest, &count16, sizeof(count16));
+            } else {
+                std::memcpy(dest, &count, sizeof(count));
+            }
+        }
+
+        ofile.write(reinterpret_cast<char const*>(counts_buffer.data()), (end - begin) * header.count_bytes);
+    }
+
+    if(!ofile) {
+        throw std::runtime_error("Error while writing " + filepath + ".");
+    }
+}
+
+MappedKmerCounter::MappedKmerCounter(string const& filepath) :
+    data(nullptr), data_size(0), header(nullptr), index(nullptr), kmers(nullptr), counts(nullptr)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Could not open " + filepath + ".");
+    }
+
+    struct stat file_stat = {};
+    if(fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(MappedKmerCounterHeader)) {
+        close(fd);
+        throw std::runtime_error(filepath + " is not a sorted k-mer counter file.");
+    }
+
+    data_size = static_cast<size_t>(file_stat.st_size);
+    data = mmap(nullptr, data_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED) {
+        data = nullptr;
+        throw std::runtime_error("Could not memory map " + filepath + ".");
+    }
+
+    // Queries jump around in the file, don't let the kernel read ahead
+    madvise(data, data_size, MADV_RANDOM);
+
+    header = static_cast<MappedKmerCounterHeader const*>(data);
+    auto invalid = [&] (string const& reason) {
+        munmap(data, data_size);
+        data = nullptr;
+
+        return std::runtime_error(filepath + ": " + reason);
+    };
+
+    if(!std::equal(std::begin(MappedKmerCounterHeader::MAGIC), std::end(MappedKmerCounterHeader::MAGIC),
+                   header->magic)) {
+        throw invalid("not a sorted k-mer counter file.");
+    }
+
+    if(header->version != MappedKmerCounterHeader::VERSION) {
+        throw invalid("unsupported file version " + std::to_string(header->version) + ".");
+    }
+
+    if(header->kmer_words != KMER_WORDS) {
+        throw invalid("written with a different maximum k-mer size.");
+    }
+
+    if(header->k != Kmer::k) {
+        throw invalid("written with k-mer size " + std::to_string(header->k) + ", but the current k-mer size is "
+                      + std::to_string(Kmer::k) + ". Set the k-mer size with `set_k_g` first.");
+    }
+
+    // Check that each section is aligned and lies within the file, without overflowing on corrupt sizes
+    auto section_fits = [&] (uint64_t offset, uint64_t num_values, size_t value_size) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= data_size
+            && num_values <= (data_size - offset) / value_size;
+    };
+
+    bool valid = header->prefix_bits <= MAX_PREFIX_BITS
+        && (header->count_bytes == 1 || header->count_bytes == 2 || header->count_bytes == 4)
+        && header->num_entries < data_size / sizeof(uint64_t)
+        && section_fits(header->index_offset, (uint64_t(1) << header->prefix_bits) + 1, sizeof(uint64_t))
+        && section_fits(header->kmers_offset, header->num_entries * KMER_WORDS, sizeof(uint64_t))
+        && section_fits(header->counts_offset, header->num_entries, header->count_bytes);
+
+    if(!valid) {
+        throw invalid("file is corrupt or truncated.");
+    }
+
+    auto base = static_cast<unsigned char const*>(data);
+    index = reinterpret_cast<uint64_t const*>(base + header->index_offset);
+    kmers = reinterpret_cast<uint64_t const*>(base + header->kmers_offset);
+    counts = base + header->counts_offset;
+
+    // The other offsets in the index are checked when used, so opening doesn't read the whole index
+    if(index[0] != 0 || index[uint64_t(1) << header->prefix_bits] != header->num_entries) {
+        throw invalid("file is corrupt or truncated.");
+    }
+}
+
+MappedKmerCounter::MappedKmerCounter(MappedKmerCounter&& o) noexcept :
+    data(o.data), data_size(o.data_size), header(o.header), index(o.index), kmers(o.kmers), counts(o.counts)
+{
+    o.data = nullptr;
+    o.data_size = 0;
+}
+
+MappedKmerCounter::~MappedKmerCounter()
+{
+    if(data != nullptr) {
+        munmap(data, data_size);
+    }
+}
+
+uint32_t MappedKmerCounter::countAt(uint64_t pos) const
+{
+    switch(header->count_bytes) {
+        case 1:
+            return counts[pos];
+        case 2: {
+            uint16_t count;
+            std::memcpy(&count, counts + pos * 2, sizeof(count));
+            return count;
+        }
+        default: {
+            uint32_t count;
+            std::memcpy(&count, counts + pos * 4, sizeof(count));
+            return count;
+        }
+    }
+}
+
+uint32_t MappedKmerCounter::query(Kmer const& qry) const
+{
+    Kmer kmer = header->canonical ? qry.rep() : qry;
+
+    uint64_t words[KMER_WORDS];
+    kmer_to_words(kmer, words);
+
+    uint64_t prefix = prefixOf(kmer, header->prefix_bits);
+    uint64_t lo = index[prefix];
+    uint64_t hi = index[prefix + 1];
+    if(lo > hi || hi > header->num_entries) {
+        throw std::runtime_error("Sorted k-mer counter file is corrupt: invalid offset in index.");
+    }
+
+    while(lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int cmp = compareWords(kmers + mid * KMER_WORDS, words);
+
+        if(cmp == 0) {
+            return countAt(mid);
+        } else if(cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t MappedKmerCounter::query(char const* qry) const
+{
+    return query(Kmer(qry));
+}
+
+template void MappedKmerCounter::write<uint16_t>(string const& filepath, size_t k, size_t g, bool canonical,
+                                                 vector<Kmer> const& keys, vector<uint16_t> const& counts,
+                                                 uint64_t num_kmers, uint64_t max_count, size_t num_threads);
+template void MappedKmerCounter::write<uint32_t>(string const& filepath, size_t k, size_t g, bool canonical,
+                                                 vector<Kmer> const& keys, vector<uint32_t> const& counts,
+                                                 uint64_t num_kmers, uint64_t max_count, size_t num_threads);
+
+
+void define_MappedKmerCounter(py::module& m) {
+    py::class_<MappedKmerCounter>(m, "MappedKmerCounter", py::module_local())
+        .def(py::init<string const&>(), py::arg("filepath"),
+             "Open a k-mer counter saved with `KmerCounter.save_sorted`.")
+
+        .def("query", py::overload_cast<Kmer const&>(&MappedKmerCounter::query, py::const_))
+        .def("query", py::overload_cast<char const*>(&MappedKmerCounter::query, py::const_))
+
+        .def("__getitem__", py::overload_cast<Kmer const&>(&MappedKmerCounter::query, py::const_))
+        .def("__getitem__", py::overload_cast<char const*>(&MappedKmerCounter::query, py::const_))
+
+        .def("__len__", [] (MappedKmerCounter const& self) {
+            return self.getUniqueKmers();
+        })
+
+        .def_property_readonly("k", &MappedKmerCounter::getK)
+        .def_property_readonly("num_kmers", &MappedKmerCounter::getNumKmers)
+        .def_property_readonly("num_unique", &MappedKmerCounter::getUniqueKmers)
+        .def_property_readonly("max_count", &MappedKmerCounter::getMaxCount);
+}
+
+}
@@ -0,0 +1,116 @@
+/**
+ * Read-only k-mer counts in a sorted on-disk format, opened with mmap.
+ *
+ * The file is written with `KmerCounter::saveSorted()`, and consists of a fixed size header followed by three
+ * sections, each aligned to 64 bytes:
+ *
+ *  1. A prefix index of `2^prefix_bits + 1` uint64 offsets. K-mers are grouped on the top `prefix_bits` bits of
+ *     their hash, and k-mers of group `i` are found at positions [index[i], index[i+1]).
+ *  2. The 2-bit packed k-mers, `kmer_words` uint64 words each, sorted on group and then on their packed words.
+ *  3. The count of each k-mer, in the same order, with the smallest width (1, 2 or 4 bytes) that fits `max_count`.
+ *
+ * Opening a file only maps it into memory, so it takes constant time, and multiple processes querying the same file
+ * share its pages through the page cache. The file is written in native byte order.
+ */
+
+#ifndef PYFROST_MAPPEDKMERCOUNTER_H
+#define PYFROST_MAPPEDKMERCOUNTER_H
+
+#include "pyfrost.h"
+#include "Kmer.h"
+
+#include <string>
+#include <vector>
+
+namespace pyfrost {
+
+/**
+ * Header of a sorted k-mer counter file.
+ */
+struct MappedKmerCounterHeader {
+    static constexpr char MAGIC[8] = {'P', 'F', 'K', 'C', 'M', 'A', 'P', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t k;
+    uint32_t g;
+    uint32_t canonical;
+    uint32_t kmer_words;
+    uint32_t count_bytes;
+    uint32_t prefix_bits;
+    uint32_t reserved;
+
+    uint64_t num_entries;
+    uint64_t num_kmers;
+    uint64_t max_count;
+
+    uint64_t index_offset;
+    uint64_t kmers_offset;
+    uint64_t counts_offset;
+};
+
+class MappedKmerCounter {
+public:
+    /**
+     * Open a file written by `KmerCounter::saveSorted()`. The k-mer size of the file has to equal the current k-mer
+     * size.
+     */
+    explicit MappedKmerCounter(std::string const& filepath);
+
+    MappedKmerCounter(MappedKmerCounter const& o) = delete;
+    MappedKmerCounter(MappedKmerCounter&& o) noexcept;
+    ~MappedKmerCounter();
+
+    MappedKmerCounter& operator=(MappedKmerCounter const& o) = delete;
+
+    /**
+     * Write unique k-mers and their counts in sorted format.
+     *
+     * @param keys Unique k-mers
+     * @param counts Count for each k-mer in `keys`
+     */
+    template<typename C>
+    static void write(std::string const& filepath, size_t k, size_t g, bool canonical, std::vector<Kmer> const& keys,
+                      std::vector<C> const& counts, uint64_t num_kmers, uint64_t max_count, size_t num_threads);
+
+    uint32_t query(Kmer const& qry) const;
+    uint32_t query(char const* qry) const;
+
+    uint64_t getNumKmers() const {
+        return header->num_kmers;
+    }
+
+    uint64_t getUniqueKmers() const {
+        return header->num_entries;
+    }
+
+    uint64_t getMaxCount() const {
+        return header->max_count;
+    }
+
+    size_t getK() const {
+        return header->k;
+    }
+
+private:
+    static uint64_t prefixOf(Kmer const& kmer, uint32_t prefix_bits) {
+        return prefix_bits > 0 ? kmer.hash() >> (64 - prefix_bits) : 0;
+    }
+
+    uint32_t countAt(uint64_t pos) const;
+
+    void* data;
+    size_t data_size;
+
+    MappedKmerCounterHeader const* header;
+    uint64_t const* index;
+    uint64_t const* kmers;
+    unsigned char const* counts;
+};
+
+void define_MappedKmerCounter(py::module& m);
+
+}
+
+#endif //PYFROST_MAPPEDKMERCOUNTER_H
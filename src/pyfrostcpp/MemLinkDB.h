@@ -69,7 +69,7 @@ T& MemLinkDB<T>::getLinks(const Kmer &kmer) {
 
 template<typename T>
 void define_MemLinkDB(py::module& m, const char* name) {
-    auto py_MemLinkDB = py::class_<MemLinkDB<T>, LinkDB>(m, name)
+    auto py_MemLinkDB = py::class_<MemLinkDB<T>, LinkDB>(m, name, py::module_local())
         .def(py::init())
         .def(py::init<size_t>())
         .def("get_links", [] (MemLinkDB<T>& self, Kmer const& kmer) -> JunctionTreeNode& {
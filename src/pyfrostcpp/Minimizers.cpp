@@ -1,11 +1,240 @@
 #include "Minimizers.h"
 #include "Kmer.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using std::vector;
+using std::string;
 
 namespace pyfrost {
 
+void MinimizerArrays::append(MinimizerArrays const& o)
+{
+    hashes.insert(hashes.end(), o.hashes.begin(), o.hashes.end());
+    positions.insert(positions.end(), o.positions.begin(), o.positions.end());
+    strands.insert(strands.end(), o.strands.begin(), o.strands.end());
+    starts.insert(starts.end(), o.starts.begin(), o.starts.end());
+    ends.insert(ends.end(), o.ends.begin(), o.ends.end());
+    seq_indices.insert(seq_indices.end(), o.seq_indices.begin(), o.seq_indices.end());
+}
+
+static bool isACGT(char c)
+{
+    switch(c) {
+        case 'A': case 'C': case 'G': case 'T':
+        case 'a': case 'c': case 'g': case 't':
+            return true;
+        default:
+            return false;
+    }
+}
+
+static char complement(char base)
+{
+    switch(base) {
+        case 'A': return 'T';
+        case 'C': return 'G';
+        case 'G': return 'C';
+        default: return 'A';
+    }
+}
+
+/**
+ * Whether an uppercase g-mer is lexicographically smaller than or equal to its reverse complement, like
+ * `Minimizer::rep`.
+ */
+static bool isForwardGmer(char const* gmer, size_t g)
+{
+    for(size_t i = 0; i < g; ++i) {
+        char rc_base = complement(gmer[g - 1 - i]);
+        if(gmer[i] != rc_base) {
+            return gmer[i] < rc_base;
+        }
+    }
+
+    return true;
+}
+
+void MinimizerScanner::scan(std::string const& sequence, MinimizerArrays& out)
+{
+    size_t run_start = 0;
+    for(size_t i = 0; i <= sequence.size(); ++i) {
+        if(i < sequence.size() && isACGT(sequence[i])) {
+            continue;
+        }
+
+        if(i - run_start >= Kmer::k) {
+            scanRun(sequence, run_start, i, out);
+        }
+
+        run_start = i + 1;
+    }
+}
+
+void MinimizerScanner::scanRun(std::string const& sequence, size_t start, size_t end, MinimizerArrays& out)
+{
+    size_t const k = Kmer::k;
+    size_t const g = Minimizer::g;
+    size_t const gmers_per_kmer = k - g + 1;
+
+    // Only ACGT bases get here, clearing the lowercase bit gives the uppercase base
+    bases.resize(end - start);
+    for(size_t i = 0; i < bases.size(); ++i) {
+        bases[i] = static_cast<char>(sequence[start + i] & ~0x20);
+    }
+
+    size_t num_gmers = bases.size() - g + 1;
+    gmer_hashes.resize(num_gmers);
+
+    RepHash hasher(g);
+    hasher.init(bases.data());
+    gmer_hashes[0] = hasher.hash();
+    for(size_t i = 1; i < num_gmers; ++i) {
+        hasher.update(bases[i - 1], bases[i + g - 1]);
+        gmer_hashes[i] = hasher.hash();
+    }
+
+    window.clear();
+    size_t window_head = 0;
+    for(size_t gmer = 0; gmer < num_gmers; ++gmer) {
+        // Keep the window's g-mer hashes non-decreasing from head to tail, a g-mer with a larger hash than a newer one
+        // can never be the minimum again. Equal hashes stay, so the head is the leftmost minimum.
+        while(window.size() > window_head && gmer_hashes[window.back()] > gmer_hashes[gmer]) {
+            window.pop_back();
+        }
+
+        window.push_back(static_cast<uint32_t>(gmer));
+        if(gmer + 1 < gmers_per_kmer) {
+            continue;
+        }
+
+        size_t kmer = gmer + 1 - gmers_per_kmer;
+        while(window[window_head] < kmer) {
+            ++window_head;
+        }
+
+        size_t min_gmer = window[window_head];
+        if(kmer > 0 && out.positions.back() == start + min_gmer) {
+            ++out.ends.back();
+            continue;
+        }
+
+        out.hashes.push_back(gmer_hashes[min_gmer]);
+        out.positions.push_back(static_cast<uint32_t>(start + min_gmer));
+        out.strands.push_back(static_cast<uint8_t>(isForwardGmer(bases.data() + min_gmer, g) ? Strand::FORWARD
+                                                                                             : Strand::REVERSE));
+        out.starts.push_back(static_cast<uint32_t>(start + kmer));
+        out.ends.push_back(static_cast<uint32_t>(start + kmer + k));
+    }
+}
+
+MinimizerArrays minimizersBatch(std::vector<std::string> const& sequences, size_t num_threads)
+{
+    // Threads process blocks of consecutive sequences, concatenated in order afterwards
+    num_threads = std::max(size_t(1), num_threads);
+    size_t block_size = std::max(size_t(1), sequences.size() / (num_threads * 8));
+    size_t num_blocks = (sequences.size() + block_size - 1) / block_size;
+    vector<MinimizerArrays> blocks(num_blocks);
+
+    std::atomic<size_t> next_block(0);
+    auto process_blocks = [&] () {
+        MinimizerScanner scanner;
+        for(size_t block_ix = next_block++; block_ix < num_blocks; block_ix = next_block++) {
+            MinimizerArrays& block = blocks[block_ix];
+            size_t end = std::min(sequences.size(), (block_ix + 1) * block_size);
+
+            for(size_t seq_ix = block_ix * block_size; seq_ix < end; ++seq_ix) {
+                scanner.scan(sequences[seq_ix], block);
+                block.seq_indices.resize(block.size(), static_cast<uint32_t>(seq_ix));
+            }
+        }
+    };
+
+    vector<std::thread> threads;
+    for(size_t i = 1; i < std::min(num_threads, num_blocks); ++i) {
+        threads.emplace_back(process_blocks);
+    }
+
+    process_blocks();
+    for(auto& t : threads) {
+        t.join();
+    }
+
+    MinimizerArrays result;
+    for(auto& block : blocks) {
+        result.append(block);
+        block = MinimizerArrays();
+    }
+
+    return result;
+}
+
+/**
+ * Set k and g for the minimizer functions below, if given. Like `minhash_iter`, this changes the global k-mer and
+ * minimizer size.
+ */
+static void setMinimizerKG(py::object const& k, py::object const& g)
+{
+    if(k.is_none() && g.is_none()) {
+        return;
+    }
+
+    size_t _k = k.is_none() ? Kmer::k : k.cast<size_t>();
+    size_t _g = g.is_none() ? 0 : g.cast<size_t>();
+    setKG(_k, _g);
+}
+
+static py::tuple minimizerArraysToTuple(MinimizerArrays&& arrays, bool with_seq_indices)
+{
+    auto hashes = as_pyarray(std::move(arrays.hashes));
+    auto positions = as_pyarray(std::move(arrays.positions));
+    auto strands = as_pyarray(std::move(arrays.strands));
+    auto starts = as_pyarray(std::move(arrays.starts));
+    auto ends = as_pyarray(std::move(arrays.ends));
+
+    if(with_seq_indices) {
+        return py::make_tuple(hashes, positions, strands, starts, ends, as_pyarray(std::move(arrays.seq_indices)));
+    } else {
+        return py::make_tuple(hashes, positions, strands, starts, ends);
+    }
+}
+
+void define_MinimizerArrays(py::module& m) {
+    m.def("minimizers_array", [] (string const& sequence, py::object const& k, py::object const& g) {
+        setMinimizerKG(k, g);
+
+        MinimizerArrays arrays;
+        {
+            py::gil_scoped_release release;
+            MinimizerScanner scanner;
+            scanner.scan(sequence, arrays);
+        }
+
+        return minimizerArraysToTuple(std::move(arrays), false);
+    }, py::arg("sequence"), py::arg("k") = py::none(), py::arg("g") = py::none(),
+        "Find the minimizer of each super-k-mer in a sequence. Returns a tuple of numpy arrays: minimizer hashes, "
+        "minimizer positions, minimizer strands, and the start and end of each super-k-mer.");
+
+    m.def("minimizers_batch", [] (vector<string> const& sequences, py::object const& k, py::object const& g,
+                                  size_t threads) {
+        setMinimizerKG(k, g);
+
+        MinimizerArrays arrays;
+        {
+            py::gil_scoped_release release;
+            arrays = minimizersBatch(sequences, threads);
+        }
+
+        return minimizerArraysToTuple(std::move(arrays), true);
+    }, py::arg("sequences"), py::arg("k") = py::none(), py::arg("g") = py::none(), py::arg("threads") = 2,
+        "Find the minimizers of the super-k-mers in a list of sequences. Returns the same arrays as "
+        "`minimizers_array`, plus the sequence index of each super-k-mer.");
+}
+
 void define_Minimizer(py::module& m) {
-    py::class_<Minimizer>(m, "Minimizer")
+    py::class_<Minimizer>(m, "Minimizer", py::module_local())
         // Constructors
         .def(py::init<>())
         .def(py::init<Minimizer const&>())
@@ -42,7 +271,7 @@ void define_Minimizer(py::module& m) {
 }
 
 void define_MinHashIterator(py::module& m) {
-    py::class_<MinHashIterator>(m, "minhash_iter")
+    py::class_<MinHashIterator>(m, "minhash_iter", py::module_local())
         .def(py::init<std::string const&>())
         .def(py::init<std::string const&, size_t>())
         .def(py::init<std::string const&, size_t, size_t>())
@@ -53,7 +282,7 @@ void define_MinHashIterator(py::module& m) {
 }
 
 void define_MinHashResult(py::module& m) {
-    py::class_<minHashResult>(m, "MinHashResult")
+    py::class_<minHashResult>(m, "MinHashResult", py::module_local())
         .def_readonly("hash", &minHashResult::hash)
         .def_readonly("pos", &minHashResult::pos)
 
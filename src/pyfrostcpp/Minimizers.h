@@ -6,6 +6,9 @@
 #include <minHashIterator.hpp>
 #include <pybind11/pybind11.h>
 
+#include <string>
+#include <vector>
+
 namespace pyfrost {
 
 class MinHashIterWrapper {
@@ -96,9 +99,68 @@ private:
 };
 
 
+/**
+ * Minimizers of one or more sequences in columnar form, one entry per super-k-mer: a maximal run of consecutive k-mers
+ * with the same minimizer, so consecutive duplicates are merged. Hashes are Bifrost's `RepHash` of the minimizer g-mer,
+ * the same minimizers as `MinHashIterator` and the graph use.
+ */
+struct MinimizerArrays {
+    std::vector<uint64_t> hashes;
+
+    /// Start position of the minimizer g-mer in the sequence, and its strand (see `Strand`)
+    std::vector<uint32_t> positions;
+    std::vector<uint8_t> strands;
+
+    /// Start position of the first k-mer of the super-k-mer, and end (exclusive) of its last k-mer
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> ends;
+
+    /// Index of the sequence of each super-k-mer, only filled by `minimizersBatch`
+    std::vector<uint32_t> seq_indices;
+
+    size_t size() const {
+        return hashes.size();
+    }
+
+    void append(MinimizerArrays const& o);
+};
+
+/**
+ * Finds the minimizer of each k-mer with a rolling `RepHash` over the g-mers and a sliding window minimum, instead of
+ * materializing the results of `minHashIterator` for every k-mer. On ties, the leftmost g-mer is the minimizer.
+ *
+ * Buffers are reused between sequences, so use one scanner per thread.
+ */
+class MinimizerScanner {
+public:
+    /**
+     * Append the super-k-mers of `sequence` to `out`. Super-k-mers end at a minimizer change or at a non-ACGT
+     * character.
+     */
+    void scan(std::string const& sequence, MinimizerArrays& out);
+
+private:
+    /**
+     * Append the super-k-mers of the ACGT-only run [start, end) of `sequence`, which is at least k bases long.
+     */
+    void scanRun(std::string const& sequence, size_t start, size_t end, MinimizerArrays& out);
+
+    // Uppercase bases of the current run, the hash of each g-mer starting at a base of the run, and the sliding window
+    // minimum queue of g-mer start positions
+    std::string bases;
+    std::vector<uint64_t> gmer_hashes;
+    std::vector<uint32_t> window;
+};
+
+/**
+ * Find the minimizers of many sequences, spread over `num_threads` threads. Output is ordered by sequence.
+ */
+MinimizerArrays minimizersBatch(std::vector<std::string> const& sequences, size_t num_threads);
+
 void define_Minimizer(py::module& m);
 void define_MinHashIterator(py::module& m);
 void define_MinHashResult(py::module& m);
+void define_MinimizerArrays(py::module& m);
 
 }
 
@@ -5,7 +5,7 @@ namespace pyfrost {
 
 void define_NodeDataDict(py::module& m) {
 
-    auto handle = py::class_<NodeDataDict>(m, "NodeDataDict")
+    auto handle = py::class_<NodeDataDict>(m, "NodeDataDict", py::module_local())
         // Dict like interface
         .def("__getitem__", &NodeDataDict::getData)
         .def("__setitem__", &NodeDataDict::setData)
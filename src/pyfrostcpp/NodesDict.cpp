@@ -3,7 +3,7 @@
 namespace pyfrost {
 
 void define_NodesDict(py::module& m) {
-    auto py_NodesDict = py::class_<NodesDict>(m, "NodesDict")
+    auto py_NodesDict = py::class_<NodesDict>(m, "NodesDict", py::module_local())
         .def(py::init<PyfrostCCDBG&>())
 
         // Access nodes with [] operator overloading
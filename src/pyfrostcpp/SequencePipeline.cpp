@@ -0,0 +1,207 @@
+#include "SequencePipeline.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <File_Parser.hpp>
+
+using std::vector;
+using std::string;
+using std::thread;
+using std::lock_guard;
+using std::unique_lock;
+using std::mutex;
+
+namespace pyfrost {
+
+SequencePipeline::SequencePipeline(size_t _num_threads, size_t _batch_size, size_t _num_readers) :
+    num_threads(std::max(size_t(1), _num_threads)), batch_size(std::max(size_t(1), _batch_size)),
+    num_readers(std::max(size_t(1), _num_readers)), finished_reading(false), streaming(false), closing(false)
+{ }
+
+SequencePipeline::~SequencePipeline()
+{
+    if(isStreaming()) {
+        finish();
+    }
+}
+
+void SequencePipeline::run(std::vector<std::string> const& files, std::function<void()> const& worker)
+{
+    if(isStreaming()) {
+        throw std::runtime_error("Can't count files during a streaming session, call finish() first.");
+    }
+
+    vector<thread> worker_threads;
+    finished_reading = false;
+
+    for(size_t i = 0; i < num_threads; ++i) {
+        worker_threads.emplace_back(worker);
+    }
+
+    thread reader_thread(&SequencePipeline::readerThread, this, std::cref(files));
+
+    for(auto& t : worker_threads) {
+        t.join();
+    }
+
+    reader_thread.join();
+}
+
+void SequencePipeline::start(std::function<void()> const& worker)
+{
+    lock_guard<mutex> guard(queue_lock);
+    if(streaming) {
+        throw std::runtime_error("A streaming session is already active, call finish() first.");
+    }
+
+    streaming = true;
+    closing = false;
+    finished_reading = false;
+
+    // Workers wait for the lock before taking their first batch
+    for(size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back(worker);
+    }
+}
+
+void SequencePipeline::feed(std::vector<std::string>&& batch)
+{
+    if(!isStreaming()) {
+        throw std::runtime_error("No active streaming session, call start() first.");
+    }
+
+    size_t max_queued = 2 * num_threads;
+    for(size_t start_ix = 0; start_ix < batch.size(); start_ix += batch_size) {
+        size_t end_ix = std::min(batch.size(), start_ix + batch_size);
+
+        auto sequences = std::make_unique<vector<string>>();
+        if(start_ix == 0 && end_ix == batch.size()) {
+            *sequences = std::move(batch);
+        } else {
+            sequences->reserve(end_ix - start_ix);
+            std::move(batch.begin() + start_ix, batch.begin() + end_ix, std::back_inserter(*sequences));
+        }
+
+        unique_lock<mutex> guard(queue_lock);
+        queue_space.wait(guard, [&] () { return seq_queue.size() < max_queued || closing; });
+
+        // Workers stop once the queue is empty after `finish`, so nothing can be queued after that
+        if(!streaming || closing) {
+            throw std::runtime_error("The streaming session was finished before the batch was queued.");
+        }
+
+        seq_queue.emplace(std::move(sequences));
+        guard.unlock();
+
+        sequence_ready.notify_one();
+    }
+}
+
+void SequencePipeline::finish()
+{
+    {
+        lock_guard<mutex> guard(queue_lock);
+        if(!streaming || closing) {
+            throw std::runtime_error("No active streaming session, call start() first.");
+        }
+
+        closing = true;
+        finished_reading = true;
+    }
+
+    sequence_ready.notify_all();
+    queue_space.notify_all();
+
+    for(auto& t : workers) {
+        t.join();
+    }
+
+    workers.clear();
+
+    lock_guard<mutex> guard(queue_lock);
+    streaming = false;
+    closing = false;
+}
+
+/**
+ * Read all files and push their sequences on the queue. Runs `num_readers` threads, each of which takes the next
+ * unread file when done with its current one.
+ */
+void SequencePipeline::readerThread(std::vector<std::string> const& files)
+{
+    std::atomic<size_t> next_file(0);
+    size_t reader_threads = std::min(num_readers, files.size());
+
+    if(reader_threads <= 1) {
+        readFiles(files, next_file);
+    } else {
+        vector<thread> readers;
+        for(size_t i = 0; i < reader_threads; ++i) {
+            readers.emplace_back(&SequencePipeline::readFiles, this, std::cref(files), std::ref(next_file));
+        }
+
+        for(auto& t : readers) {
+            t.join();
+        }
+    }
+
+    setFinished();
+}
+
+void SequencePipeline::readFiles(std::vector<std::string> const& files, std::atomic<size_t>& next_file)
+{
+    auto sequences = std::make_unique<vector<string>>();
+    sequences->reserve(batch_size);
+
+    for(size_t file_ix = next_file++; file_ix < files.size(); file_ix = next_file++) {
+        FileParser fp(vector<string> {files[file_ix]});
+
+        string sequence;
+        size_t fp_file_ix = 0;
+        while(fp.read(sequence, fp_file_ix)) {
+            sequences->emplace_back(sequence);
+
+            if(sequences->size() >= batch_size) {
+                // When enough data read, push sequences on the queue. This way we don't have to lock the queue that
+                // often.
+                push(std::move(sequences));
+
+                sequences = std::make_unique<vector<string>>();
+                sequences->reserve(batch_size);
+            }
+        }
+    }
+
+    // Push remaining sequences on the queue
+    if(!sequences->empty()) {
+        push(std::move(sequences));
+    }
+}
+
+void SequencePipeline::push(std::unique_ptr<std::vector<std::string>>&& sequences)
+{
+    unique_lock<mutex> guard(queue_lock);
+    seq_queue.emplace(std::move(sequences));
+    guard.unlock();
+
+    sequence_ready.notify_one();
+}
+
+void SequencePipeline::setFinished()
+{
+    {
+        // Set under the queue lock, otherwise a worker that just checked the flag could miss the notification
+        lock_guard<mutex> guard(queue_lock);
+        finished_reading = true;
+    }
+
+    sequence_ready.notify_all();
+}
+
+size_t minimizerPartition(Kmer const& kmer, size_t num_partitions)
+{
+    return kmerMinimizerHash(kmer) % num_partitions;
+}
+
+}
@@ -0,0 +1,187 @@
+/**
+ * Producer/consumer pipeline that distributes batches of sequences over counter threads.
+ *
+ * Sequences enter the pipeline either from FASTA/FASTQ files, parsed by one or more reader threads, or from batches
+ * passed to `feed` during a streaming session. Worker threads take whole batches from a shared queue with
+ * `processQueue`, so the queue lock is taken once per batch instead of once per sequence.
+ *
+ * Also contains the minimizer based partitioning of k-mers shared by the k-mer counters: a k-mer is assigned to a
+ * partition by its minimizer hash, so consecutive k-mers in a read mostly map to the same partition. K-mers and
+ * minimizers are extracted in a single pass with `KmerScanner`.
+ */
+
+#ifndef PYFROST_SEQUENCEPIPELINE_H
+#define PYFROST_SEQUENCEPIPELINE_H
+
+#include "Kmer.h"
+#include "KmerScanner.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pyfrost {
+
+class SequencePipeline {
+public:
+    /**
+     * @param num_threads Number of worker threads
+     * @param batch_size Number of sequences per batch on the queue
+     * @param num_readers Number of threads reading input files, each parsing a different file at a time
+     */
+    SequencePipeline(size_t num_threads, size_t batch_size, size_t num_readers);
+    ~SequencePipeline();
+
+    /**
+     * Read all sequences in `files`, while running `worker` on `num_threads` threads. Workers should call
+     * `processQueue`, which returns when all files are read and the queue is empty.
+     */
+    void run(std::vector<std::string> const& files, std::function<void()> const& worker);
+
+    /**
+     * Start a streaming session: spawns `num_threads` threads running `worker`, which keep processing batches passed
+     * to `feed` until `finish` is called. Throws if a session is already active.
+     */
+    void start(std::function<void()> const& worker);
+
+    /**
+     * Queue a batch of sequences during a streaming session. Blocks while the queue is full, which is at
+     * `2 * num_threads` batches, so a fast producer can't run ahead of the workers. Batches larger than `batch_size`
+     * are split, so they are spread over all threads. Safe to call from multiple threads. Throws if the session is
+     * finished before the whole batch is queued.
+     */
+    void feed(std::vector<std::string>&& batch);
+
+    /**
+     * End the streaming session: waits until all queued sequences are processed and joins the worker threads. Batches
+     * fed after this is called are rejected.
+     */
+    void finish();
+
+    bool isStreaming() const {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        return streaming;
+    }
+
+    /**
+     * Worker loop: take batches of sequences from the queue and call `process` for each sequence, until the input is
+     * finished and the queue is empty.
+     */
+    template<typename F>
+    void processQueue(F&& process) {
+        while(true) {
+            // Wait until sequences are available in the queue
+            std::unique_lock<std::mutex> guard(queue_lock);
+            sequence_ready.wait(guard, [&] () { return !seq_queue.empty() || finished_reading; });
+
+            if(seq_queue.empty() && finished_reading) {
+                return;
+            }
+
+            // Obtain block of sequences to process
+            std::unique_ptr<std::vector<std::string>> sequences = std::move(seq_queue.front());
+            seq_queue.pop();
+            guard.unlock();
+            queue_space.notify_one();
+
+            for(auto const& sequence : *sequences) {
+                process(sequence);
+            }
+        }
+    }
+
+private:
+    void readerThread(std::vector<std::string> const& files);
+    void readFiles(std::vector<std::string> const& files, std::atomic<size_t>& next_file);
+    void push(std::unique_ptr<std::vector<std::string>>&& sequences);
+    void setFinished();
+
+    size_t num_threads;
+    size_t batch_size;
+    size_t num_readers;
+
+    std::atomic<bool> finished_reading;
+    mutable std::mutex queue_lock;
+    std::condition_variable sequence_ready;
+    std::condition_variable queue_space;
+    std::queue<std::unique_ptr<std::vector<std::string>>> seq_queue;
+
+    // Streaming session state, guarded by `queue_lock`. A session is closing from the start of `finish` until its
+    // workers are joined.
+    bool streaming;
+    bool closing;
+    std::vector<std::thread> workers;
+};
+
+/**
+ * Partition of a k-mer: its minimizer hash, as computed by `KmerScanner`, modulo the number of partitions. The
+ * minimizer hash only depends on the k-mer itself and is strand independent, so this equals the partition
+ * `forEachSuperKmer` assigns while reading sequences, and a k-mer and its reverse complement map to the same partition.
+ */
+size_t minimizerPartition(Kmer const& kmer, size_t num_partitions);
+
+/**
+ * A run of consecutive k-mers in a sequence, pointing into the output of a `KmerScanner`.
+ */
+class KmerRun {
+public:
+    KmerRun(Kmer const* _first, size_t _length) : first(_first), length(_length) { }
+
+    Kmer const* begin() const {
+        return first;
+    }
+
+    Kmer const* end() const {
+        return first + length;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    Kmer const& operator[](size_t i) const {
+        return first[i];
+    }
+
+private:
+    Kmer const* first;
+    size_t length;
+};
+
+/**
+ * Cut a sequence into super-k-mers: maximal runs of consecutive k-mers that map to the same partition. For each run,
+ * `callback` is called with the partition, the (canonical if requested) k-mers in the run, and the position of the
+ * first k-mer in the sequence.
+ */
+template<typename F>
+void forEachSuperKmer(std::string const& sequence, size_t num_partitions, bool canonical, F&& callback)
+{
+    thread_local KmerScanner scanner;
+    size_t num_kmers = scanner.scan(sequence, canonical, true);
+
+    size_t run_start = 0;
+    size_t run_partition = num_kmers > 0 ? scanner.minimizerHash(0) % num_partitions : 0;
+
+    for(size_t i = 1; i <= num_kmers; ++i) {
+        size_t partition = i < num_kmers ? scanner.minimizerHash(i) % num_partitions : run_partition;
+
+        // A super-k-mer ends when the partition changes, or when k-mers were skipped because of a non-ACGT char
+        if(i == num_kmers || partition != run_partition || scanner.position(i) != scanner.position(i - 1) + 1) {
+            callback(run_partition, KmerRun(&scanner.kmer(run_start), i - run_start),
+                     static_cast<int>(scanner.position(run_start)));
+
+            run_start = i;
+            run_partition = partition;
+        }
+    }
+}
+
+}
+
+#endif //PYFROST_SEQUENCEPIPELINE_H
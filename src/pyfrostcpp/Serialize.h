@@ -8,6 +8,151 @@
 #include <cereal/types/memory.hpp>
 #include <robin_hood.h>
 #include <tl/optional.hpp>
+#include <Kmer.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Cereal serialization support for Kmer. Binary archives store the packed k-mer words directly, text archives a
+// string with the bytes written by `Kmer::write`.
+template<typename Archive, cereal::traits::DisableIf<cereal::traits::is_text_archive<Archive>::value>
+    = cereal::traits::sfinae>
+void save(Archive& ar, Kmer const& kmer)
+{
+    ar(cereal::binary_data(&kmer, sizeof(Kmer)));
+}
+
+template<typename Archive, cereal::traits::DisableIf<cereal::traits::is_text_archive<Archive>::value>
+    = cereal::traits::sfinae>
+void load(Archive& ar, Kmer& kmer)
+{
+    ar(cereal::binary_data(&kmer, sizeof(Kmer)));
+}
+
+template<typename Archive, cereal::traits::EnableIf<cereal::traits::is_text_archive<Archive>::value>
+    = cereal::traits::sfinae>
+std::string save_minimal(Archive& ar, Kmer const& kmer)
+{
+    std::stringstream bytes;
+    kmer.write(bytes);
+
+    return bytes.str();
+}
+
+template<typename Archive, cereal::traits::EnableIf<cereal::traits::is_text_archive<Archive>::value>
+    = cereal::traits::sfinae>
+void load_minimal(Archive& ar, Kmer& kmer, std::string const& value)
+{
+    std::istringstream stream(value);
+    kmer.read(stream);
+}
+
+namespace pyfrost {
+
+/**
+ * Containers of k-mers start with this tag and a format version. Older versions stored each k-mer as a length
+ * prefixed string, and their containers start with the number of entries, which can never equal the tag.
+ */
+constexpr uint64_t KMER_FORMAT_TAG = ~uint64_t(0);
+constexpr uint32_t KMER_FORMAT_VERSION = 1;
+
+template<typename Archive>
+void save_kmer_format(Archive& ar) {
+    ar(KMER_FORMAT_TAG, KMER_FORMAT_VERSION);
+}
+
+/**
+ * Read the header written by `save_kmer_format`, and return whether the container uses the legacy k-mer format. In
+ * that case there is no header, and `legacy_size` gets the number of entries stored in its place.
+ */
+template<typename Archive>
+bool load_kmer_format(Archive& ar, uint64_t& legacy_size) {
+    uint64_t tag;
+    ar(tag);
+
+    if(tag != KMER_FORMAT_TAG) {
+        legacy_size = tag;
+        return true;
+    }
+
+    uint32_t version;
+    ar(version);
+    if(version > KMER_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported k-mer format version " + std::to_string(version)
+                                 + ", the file was written by a newer version of pyfrost.");
+    }
+
+    return false;
+}
+
+/**
+ * Count type of k-mer counters saved in the legacy format, which didn't support other count widths yet.
+ */
+using LegacyCount = uint16_t;
+
+/**
+ * Saved k-mer counters store the width of their count slots in bytes after the k-mer size, minimizer size and canonical
+ * flag, preceded by this tag. Counters saved before the width was recorded have the number of tables or k-mers in its
+ * place, which can never equal the tag.
+ */
+constexpr uint64_t COUNT_WIDTH_TAG = ~uint64_t(0);
+
+/**
+ * Throw if a file stores counts of `width` bytes, and the counter loading it uses slots of type `T`.
+ */
+template<typename T>
+void check_count_width(uint32_t width) {
+    if(width != sizeof(T)) {
+        throw std::runtime_error("The file stores " + std::to_string(8 * width) + "-bit counts, but this counter has "
+                                 + std::to_string(8 * sizeof(T)) + "-bit counts. Load it with the counter class of "
+                                 "the same count width.");
+    }
+}
+
+template<typename T, typename Archive>
+void save_count_width(Archive& ar) {
+    ar(COUNT_WIDTH_TAG, static_cast<uint32_t>(sizeof(T)));
+}
+
+/**
+ * Read the count width written by `save_count_width` and check it matches `T`. Returns false for files saved before
+ * the count width was recorded, in which case `untagged` gets the value stored in its place.
+ */
+template<typename T, typename Archive>
+bool load_count_width(Archive& ar, uint64_t& untagged) {
+    uint64_t tag;
+    ar(tag);
+
+    if(tag != COUNT_WIDTH_TAG) {
+        untagged = tag;
+        return false;
+    }
+
+    uint32_t width;
+    ar(width);
+    check_count_width<T>(width);
+
+    return true;
+}
+
+/**
+ * Load a k-mer stored in the legacy format, as length prefixed string with the bytes written by `Kmer::write`.
+ */
+struct LegacyKmer {
+    Kmer& kmer;
+};
+
+template<typename Archive>
+void load(Archive& ar, LegacyKmer& legacy) {
+    std::string bytes;
+    ar(bytes);
+
+    std::istringstream stream(bytes);
+    legacy.kmer.read(stream);
+}
+
+}
 
 // Cereal serialization support for robin_hood::unordered_map
 namespace robin_hood {
@@ -38,6 +183,43 @@ void load(Archive& ar, unordered_map<K, V, C, A>& map) {
     }
 }
 
+// Maps with k-mer keys start with a format tag, so maps saved with the legacy k-mer format can still be loaded
+template <typename Archive, typename V, typename C, typename A>
+void save(Archive& ar, unordered_map<Kmer, V, C, A> const& map) {
+    pyfrost::save_kmer_format(ar);
+
+    ar(map.size());
+    for(auto const& e: map) {
+        ar(e.first, e.second);
+    }
+}
+
+template <typename Archive, typename V, typename C, typename A>
+void load(Archive& ar, unordered_map<Kmer, V, C, A>& map) {
+    map.clear();
+
+    uint64_t num_entries;
+    bool legacy = pyfrost::load_kmer_format(ar, num_entries);
+    if(!legacy) {
+        ar(num_entries);
+    }
+
+    map.reserve(num_entries);
+
+    for(uint64_t i = 0; i < num_entries; ++i) {
+        Kmer key;
+        V value;
+        if(legacy) {
+            ar(pyfrost::LegacyKmer {key});
+        } else {
+            ar(key);
+        }
+        ar(value);
+
+        map.emplace(std::move(key), std::move(value));
+    }
+}
+
 }
 
 namespace tl {
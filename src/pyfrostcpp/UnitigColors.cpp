@@ -48,7 +48,7 @@ bool UnitigColorIterator::operator!=(const UnitigColorIterator &o) {
 
 
 void define_UnitigColors(py::module &m) {
-    auto py_UnitigColors = py::class_<UnitigColorsProxy>(m, "UnitigColors")
+    auto py_UnitigColors = py::class_<UnitigColorsProxy>(m, "UnitigColors", py::module_local())
         .def("__getitem__", &UnitigColorsProxy::getColorsAtPos)
         .def("__contains__", &UnitigColorsProxy::contains)
         .def("__len__", &UnitigColorsProxy::size)
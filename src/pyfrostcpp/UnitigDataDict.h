@@ -11,33 +11,51 @@ namespace pyfrost {
 /**
  * Custom unitig data class for use with Bifrost's `ColoredCDBG`, Associates a python dict with every unitig in the
  * graph.
+ *
+ * Bifrost creates, copies and clears unitig data from its worker threads, e.g., while building or merging graphs. The
+ * dict is therefore only created when Python first accesses it, and the GIL is acquired whenever an existing dict is
+ * copied or released. Unitigs without user data never touch Python objects, so Bifrost can run with the GIL released.
  */
 class UnitigDataDict : public CCDBG_Data_t<UnitigDataDict> {
 public:
-    UnitigDataDict() { }
+    UnitigDataDict() : data(emptyHandle()) { }
+
+    UnitigDataDict(UnitigDataDict const& o) : data(emptyHandle()) {
+        if(o.data) {
+            py::gil_scoped_acquire acquire;
+            data = o.data;
+        }
+    }
 
-    UnitigDataDict(UnitigDataDict const& o) : data(o.data) { }
     UnitigDataDict(UnitigDataDict&& o) noexcept : data(std::move(o.data)) { }
 
+    ~UnitigDataDict() {
+        resetDict();
+    }
+
     UnitigDataDict& operator=(UnitigDataDict const& o) {
-        data = o.data;
+        if(data || o.data) {
+            py::gil_scoped_acquire acquire;
+            data = o.data ? o.data : emptyHandle();
+        }
+
         return *this;
     }
 
     void clear(UnitigColorMap<UnitigDataDict> const& um) {
-        data.clear();
+        resetDict();
     }
 
     void concat(UnitigColorMap<UnitigDataDict> const& um_dest, UnitigColorMap<UnitigDataDict> const& um_src) {
         // Two unitigs get concatenated. Currently we don't merge any data because it's a new unitig.
         // Maybe in the future try to intelligently merge data? Bit hard because the dict can contain all kinds
         // of data
-        data.clear();
+        resetDict();
     }
 
     void extract(UnitigColors const* uc_dest, UnitigColorMap<UnitigDataDict> const& um_src, bool last_extraction) {
         // Again, just clear the dictionary. Hard to handle user data in the dict that can be all kinds of types.
-        data.clear();
+        resetDict();
     }
 
     std::string serialize(const_UnitigColorMap<UnitigDataDict> const& um) const {
@@ -45,11 +63,32 @@ public:
         return std::string();
     }
 
+    /**
+     * Get the user data dict, creating it if this unitig doesn't have one yet. Requires the GIL.
+     */
     py::dict& getDict() {
+        if(!data) {
+            data = py::dict();
+        }
+
         return data;
     }
 
 private:
+    /**
+     * A dict handle that doesn't point to a Python object yet, creating it doesn't need the GIL.
+     */
+    static py::dict emptyHandle() {
+        return py::reinterpret_steal<py::dict>(py::handle());
+    }
+
+    void resetDict() {
+        if(data) {
+            py::gil_scoped_acquire acquire;
+            data = emptyHandle();
+        }
+    }
+
     py::dict data;
 
 };
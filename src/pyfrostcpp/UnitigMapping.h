@@ -10,11 +10,11 @@ namespace py = pybind11;
 namespace pyfrost {
 
 void define_UnitigMapping(py::module& m) {
-    py::enum_<Strand>(m, "Strand")
+    py::enum_<Strand>(m, "Strand", py::module_local())
         .value("REVERSE", Strand::REVERSE, "Reverse orientation")
         .value("FORWARD", Strand::FORWARD, "Forward orientation");
 
-    py::class_<PyfrostColoredUMap>(m, "UnitigMapping")
+    py::class_<PyfrostColoredUMap>(m, "UnitigMapping", py::module_local())
         // Unitig head and tail k-mers
         .def_property_readonly("head", [] (PyfrostColoredUMap const& self) {
             return self.strand ? self.getUnitigHead() : self.getUnitigTail().twin();
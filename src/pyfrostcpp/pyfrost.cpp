@@ -1,10 +1,21 @@
 #include <string>
 #include <vector>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 
 #include "pyfrost.h"
 #include "Kmer.h"
+#include "KmerArray.h"
 #include "Minimizers.h"
+#include "KmerScanner.h"
+#include "FracMinHash.h"
 #include "KmerCounter.h"
+#include "FrozenKmerCounter.h"
+#include "MappedKmerCounter.h"
+#include "GraphSnapshot.h"
+#include "ApproxKmerCounter.h"
 #include "UnitigDataDict.h"
 #include "NodeDataDict.h"
 #include "UnitigMapping.h"
@@ -35,7 +46,8 @@ void setKG(size_t k, size_t g)
     if(k >= MAX_KMER_SIZE) {
         const uint16_t max_kmer_size = MAX_KMER_SIZE - 1;
         std::stringstream error_msg;
-        error_msg << "K-mer size is too big! Max k-mer size: " << max_kmer_size;
+        error_msg << "K-mer size is too big! Max k-mer size: " << max_kmer_size << ". To use larger k-mers, build "
+                  << "pyfrost with EXTRA_MAX_KMER_SIZES.";
         throw std::out_of_range(error_msg.str());
     }
 
@@ -95,7 +107,7 @@ void removeUnitig(PyfrostCCDBG& g, char const* kmer) {
 }
 
 void define_PyfrostCCDBG(py::module& m) {
-    py::class_<PyfrostCCDBG>(m, "PyfrostCCDBG")
+    py::class_<PyfrostCCDBG>(m, "PyfrostCCDBG", py::module_local())
         .def("get_k", [] (PyfrostCCDBG const& self) {
             return self.getK();
         })
@@ -190,6 +202,134 @@ PyfrostCCDBG build(py::list const& input_ref_files, py::list const& input_seq_fi
     return ccdbg;
 }
 
+/**
+ * Build a colored graph from all k-mers in `counter` with a count of at least `min_count`, without reading the
+ * original sequencing data again.
+ *
+ * Bifrost builds graphs from files, so the solid k-mers are written to a temporary FASTA file, which is used as
+ * reference input (no further abundance filtering by Bifrost). The graph gets a single color. Bifrost names it after
+ * the temporary file, the Python wrapper renames it to `color_name`.
+ */
+template<typename T>
+PyfrostCCDBG build_from_counter(KmerCounter<T> const& counter, size_t min_count, py::kwargs const& kwargs) {
+    CCDBG_Build_opt opt;
+    opt.k = static_cast<int>(counter.getK());
+    if(counter.getG() > 0) {
+        opt.g = static_cast<int>(counter.getG());
+    }
+
+    populate_options(opt, kwargs);
+
+    if(static_cast<size_t>(opt.k) != counter.getK()) {
+        throw std::runtime_error("Graph k-mer size should equal the k-mer size of the counter.");
+    }
+
+    string tmp_dir = kwargs.contains("tmp_dir") ? py::cast<string>(kwargs["tmp_dir"]) : "";
+    if(tmp_dir.empty()) {
+        char const* env_tmp = std::getenv("TMPDIR");
+        tmp_dir = env_tmp != nullptr ? env_tmp : "/tmp";
+    }
+
+    string color_name = kwargs.contains("color_name") ? py::cast<string>(kwargs["color_name"]) : "counter";
+
+    // The color name becomes a file name in the temporary directory, it shouldn't point anywhere else
+    if(color_name.empty() || color_name == "." || color_name.find('/') != string::npos
+            || color_name.find('\\') != string::npos || color_name.find("..") != string::npos) {
+        throw std::invalid_argument("Invalid color name '" + color_name + "', it should be a plain name without "
+                                    "path separators or '..'.");
+    }
+
+    // Bifrost uses the input file path as color name, so create a directory to be able to name the file freely
+    string dir_template = tmp_dir + "/pyfrost_counter.XXXXXX";
+    vector<char> dir_path(dir_template.begin(), dir_template.end());
+    dir_path.push_back('\0');
+
+    if(mkdtemp(dir_path.data()) == nullptr) {
+        throw std::runtime_error("Could not create temporary directory in " + tmp_dir);
+    }
+
+    string kmers_file = string(dir_path.data()) + "/" + color_name + ".fasta";
+    auto cleanup = [&] () {
+        std::remove(kmers_file.c_str());
+        rmdir(dir_path.data());
+    };
+
+    try {
+        auto count_threshold = static_cast<typename KmerCounter<T>::count_type>(
+            std::min<size_t>(min_count, std::numeric_limits<typename KmerCounter<T>::count_type>::max()));
+        counter.writeSolidKmers(kmers_file, count_threshold);
+
+        opt.filename_ref_in = {kmers_file};
+
+        PyfrostCCDBG ccdbg(opt.k, opt.g);
+        if(!ccdbg.buildGraph(opt)) {
+            throw std::runtime_error("Error building the graph.");
+        }
+
+        ccdbg.simplify(opt.deleteIsolated, opt.clipTips, opt.verbose);
+
+        if(!ccdbg.buildColors(opt)) {
+            throw std::runtime_error("Error building coloring of the graph.");
+        }
+
+        cleanup();
+        return ccdbg;
+    } catch(...) {
+        cleanup();
+        throw;
+    }
+}
+
+/**
+ * Add new samples to an existing graph, each file becomes a new color.
+ *
+ * A graph is built from the new files only, and merged into `g` by Bifrost. This inserts the new k-mers and only
+ * splits or joins the unitigs they touch, so the cost depends on the size of the new data instead of the size of the
+ * whole graph. The GIL is released while Bifrost builds and merges, `UnitigDataDict` acquires it when Bifrost's
+ * threads release the user data of unitigs that change.
+ */
+void add_samples(PyfrostCCDBG& g, py::list const& input_ref_files, py::list const& input_seq_files,
+                 py::kwargs const& kwargs) {
+    CCDBG_Build_opt opt;
+    opt.k = g.getK();
+    opt.g = g.getG();
+
+    for(auto const& item : input_ref_files) {
+        opt.filename_ref_in.emplace_back(py::cast<string>(item));
+    }
+
+    for(auto const& item : input_seq_files) {
+        opt.filename_seq_in.emplace_back(py::cast<string>(item));
+    }
+
+    populate_options(opt, kwargs);
+
+    if(opt.k != g.getK() || opt.g != g.getG()) {
+        throw std::runtime_error("The k-mer and minimizer size of new samples should equal those of the graph.");
+    }
+
+    if(opt.filename_ref_in.empty() && opt.filename_seq_in.empty()) {
+        return;
+    }
+
+    py::gil_scoped_release release;
+
+    PyfrostCCDBG new_samples(opt.k, opt.g);
+    if(!new_samples.buildGraph(opt)) {
+        throw std::runtime_error("Error building the graph of the new samples.");
+    }
+
+    new_samples.simplify(opt.deleteIsolated, opt.clipTips, opt.verbose);
+
+    if(!new_samples.buildColors(opt)) {
+        throw std::runtime_error("Error building coloring of the new samples.");
+    }
+
+    if(!g.merge(std::move(new_samples), opt.nb_threads, opt.verbose)) {
+        throw std::runtime_error("Error merging the new samples into the graph.");
+    }
+}
+
 PyfrostCCDBG load(char const* input_graph_file, char const* input_color_file, py::kwargs const& kwargs) {
     CCDBG_Build_opt opt;
     opt.filename_graph_in = input_graph_file;
@@ -213,7 +353,13 @@ void dump(PyfrostCCDBG& g, string const& fname_prefix, size_t num_threads=2) {
 
 }
 
-PYBIND11_MODULE(pyfrostcpp, m) {
+// Builds with a different MAX_KMER_SIZE use a different module name, see EXTRA_MAX_KMER_SIZES in CMakeLists.txt. All
+// types are registered with `py::module_local()`, so modules of different widths can be loaded in the same process.
+#ifndef PYFROST_MODULE_NAME
+#define PYFROST_MODULE_NAME pyfrostcpp
+#endif
+
+PYBIND11_MODULE(PYFROST_MODULE_NAME, m) {
     m.doc() = R"doc(
         Python bindings for Bifrost
         ===========================
@@ -224,18 +370,30 @@ PYBIND11_MODULE(pyfrostcpp, m) {
 
     m.attr("default_k") = DEFAULT_K;
 
-    py::bind_vector<std::vector<std::string>>(m, "StringVector");
-    py::bind_map<std::unordered_map<Kmer, size_t>>(m, "KmerSizeTMap");
+    py::bind_vector<std::vector<std::string>>(m, "StringVector", py::module_local());
+    py::bind_map<std::unordered_map<Kmer, size_t>>(m, "KmerSizeTMap", py::module_local());
     py::implicitly_convertible<py::list, std::vector<std::string>>();
 
     pyfrost::define_Kmer(m);
-    pyfrost::define_KmerCounter(m);
+    pyfrost::define_KmerArray(m);
+    pyfrost::define_KmerCounter<uint16_t>(m, "KmerCounter");
+    pyfrost::define_KmerCounter<uint8_t>(m, "KmerCounter8");
+    pyfrost::define_KmerCounter<uint32_t>(m, "KmerCounter32");
+    pyfrost::define_FrozenKmerCounter<uint16_t>(m, "FrozenKmerCounter");
+    pyfrost::define_FrozenKmerCounter<uint8_t>(m, "FrozenKmerCounter8");
+    pyfrost::define_FrozenKmerCounter<uint32_t>(m, "FrozenKmerCounter32");
+    pyfrost::define_MappedKmerCounter(m);
+    pyfrost::define_ApproxKmerCounter(m);
 
     pyfrost::define_Minimizer(m);
     pyfrost::define_MinHashIterator(m);
     pyfrost::define_MinHashResult(m);
+    pyfrost::define_MinimizerArrays(m);
+    pyfrost::define_KmerScanner(m);
+    pyfrost::define_FracMinHash(m);
 
     pyfrost::define_PyfrostCCDBG(m);
+    pyfrost::define_GraphSnapshot(m);
     pyfrost::define_UnitigColors(m);
     pyfrost::define_NodeDataDict(m);
     pyfrost::define_UnitigMapping(m);
@@ -254,6 +412,12 @@ PYBIND11_MODULE(pyfrostcpp, m) {
           "Load an existing colored Bifrost graph from a file.");
     m.def("build", &pyfrost::build,
           "Build a colored compacted Bifrost graph from references and sequencing data.");
+    m.def("build_from_counter", &pyfrost::build_from_counter<uint16_t>, py::arg("counter"), py::arg("min_count") = 2,
+          "Build a colored compacted Bifrost graph from the k-mers in a KmerCounter with a minimum count.");
+    m.def("build_from_counter", &pyfrost::build_from_counter<uint8_t>, py::arg("counter"), py::arg("min_count") = 2);
+    m.def("build_from_counter", &pyfrost::build_from_counter<uint32_t>, py::arg("counter"), py::arg("min_count") = 2);
+    m.def("add_samples", &pyfrost::add_samples, py::arg("g"), py::arg("input_ref_files"), py::arg("input_seq_files"),
+          "Add references and sequencing data to an existing graph, with a new color for each file.");
     m.def("dump", &pyfrost::dump, py::arg("g"), py::arg("fname_prefix"), py::arg("num_threads") = 2,
           "Save graph to file.");
 
@@ -34,6 +34,19 @@ inline py::array_t<typename Sequence::value_type> as_pyarray(Sequence&& seq) {
     return py::array_t<typename Sequence::value_type>(size, data, capsule);
 }
 
+/**
+ * Same as above, but creates a multidimensional array with the given shape. The number of elements in `seq` should
+ * equal the product of the shape.
+ */
+template <typename Sequence>
+inline py::array_t<typename Sequence::value_type> as_pyarray(Sequence&& seq, std::vector<size_t> const& shape) {
+    auto data = seq.data();
+    std::unique_ptr<Sequence> seq_ptr = std::make_unique<Sequence>(std::forward<Sequence>(seq));
+    auto capsule = py::capsule(seq_ptr.get(), [](void *p) { std::unique_ptr<Sequence>(reinterpret_cast<Sequence*>(p)); });
+    seq_ptr.release();
+    return py::array_t<typename Sequence::value_type>(shape, data, capsule);
+}
+
 using PyfrostCCDBG = ColoredCDBG<UnitigDataDict>;
 
 enum class Strand : uint8_t {
@@ -1,3 +1,5 @@
+import sys
+
 import pytest
 
 import pyfrost
@@ -161,3 +163,58 @@ def test_in_out_edges(mccortex):
 
     assert g.edges[n1, n2]['orientation'] == (g.nodes[n1]['strand'], g.nodes[n2]['strand'])
     assert g.edges[n1, n2]['label'] == "T"
+
+
+def test_snapshot(mccortex2, tmp_path):
+    g = mccortex2
+    pyfrost.dump_snapshot(g, tmp_path / "graph.snap")
+
+    pyfrost.set_k_g(g.graph['k'], g.graph['g'])
+    snapshot = pyfrost.load_snapshot(tmp_path / "graph.snap")
+    assert snapshot.k == g.graph['k']
+    assert snapshot.color_names == g.graph['color_names']
+
+    sequences = {snapshot.unitig_sequence(i) for i in range(snapshot.num_unitigs)}
+    assert len(sequences) * 2 == len(g.nodes)
+
+    for n, data in g.nodes(data=True):
+        unitig, pos, forward = snapshot.find(n)
+        unitig_seq = snapshot.unitig_sequence(unitig)
+        assert data['unitig_sequence'] in (unitig_seq, pyfrost.reverse_complement(unitig_seq))
+        assert set(snapshot.unitig_colors(unitig)) == set(data['colors'])
+
+        kmer_seq = unitig_seq[pos:pos + snapshot.k]
+        assert (kmer_seq if forward else pyfrost.reverse_complement(kmer_seq)) == str(n)
+        assert n in snapshot
+        assert set(snapshot.kmer_colors(n)) <= set(data['colors'])
+
+    assert len(snapshot) == sum(len(seq) - snapshot.k + 1 for seq in sequences)
+
+
+def test_snapshot_checks(mccortex2, tmp_path):
+    spill_dir = tmp_path / "spill"
+    spill_dir.mkdir()
+
+    pyfrost.dump_snapshot(mccortex2, tmp_path / "graph.snap", num_threads=3, tmp_dir=spill_dir)
+    assert not list(spill_dir.iterdir())
+
+    # Opening a snapshot doesn't change the k-mer size of graphs that are already open
+    pyfrost.set_k_g(7, 5)
+    with pytest.raises(RuntimeError, match="k-mer size"):
+        pyfrost.load_snapshot(tmp_path / "graph.snap")
+
+    pyfrost.set_k_g(mccortex2.graph['k'], mccortex2.graph['g'])
+    data = (tmp_path / "graph.snap").read_bytes()
+
+    (tmp_path / "truncated.snap").write_bytes(data[:len(data) // 2])
+    with pytest.raises(RuntimeError, match="corrupt"):
+        pyfrost.load_snapshot(tmp_path / "truncated.snap")
+
+    # Offset of the k-mers section offset in the header, after magic[8], six uint32 fields, six uint64 counts and four
+    # other offsets
+    kmers_offset = 8 + 6 * 4 + 6 * 8 + 4 * 8
+    corrupt = bytearray(data)
+    corrupt[kmers_offset:kmers_offset + 8] = (2**62).to_bytes(8, sys.byteorder)
+    (tmp_path / "corrupt.snap").write_bytes(bytes(corrupt))
+    with pytest.raises(RuntimeError, match="corrupt"):
+        pyfrost.load_snapshot(tmp_path / "corrupt.snap")
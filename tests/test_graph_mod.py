@@ -2,7 +2,8 @@
 Test modification of graphs (add/removing nodes etc.)
 """
 
-from pyfrost import Kmer
+import pyfrost
+from pyfrost import Kmer, reverse_complement
 
 
 def test_remove_unitig(mccortex):
@@ -12,3 +13,29 @@ def test_remove_unitig(mccortex):
 
     assert kmer not in mccortex
     assert kmer.twin() not in mccortex
+
+
+def test_add_samples(mccortex2):
+    g = pyfrost.build_from_refs(['data/mccortex.fasta'], k=5, g=3)
+
+    # Bifrost's threads release the user data of unitigs changed by the merge, while the GIL is released
+    for n in g.nodes:
+        g.nodes[n]['visited'] = [n]
+
+    pyfrost.add_samples(g, ['data/mccortex2.fasta'], threads=4)
+
+    assert g.graph['color_names'] == mccortex2.graph['color_names']
+
+    def unitig_colors(graph):
+        unitigs = {}
+        for n, data in graph.nodes(data=True):
+            seq = data['unitig_sequence']
+            unitigs[min(seq, reverse_complement(seq))] = set(data['colors'])
+
+        return unitigs
+
+    # Same unitigs with the same colors as a graph built from both files at once
+    assert unitig_colors(g) == unitig_colors(mccortex2)
+
+    for n, data in g.nodes(data=True):
+        assert data.get('visited', [n]) == [n]
@@ -1,8 +1,13 @@
+import random
+import struct
 from collections import Counter
 
+import numpy
 import pytest  # noqa
 
-from pyfrost import Kmer, KmerCounter
+import pyfrost
+from pyfrost import (max_k, Kmer, KmerCounter, KmerCounter8, KmerCounter32, FrozenKmerCounter, MappedKmerCounter,
+                     ApproxKmerCounter)
 
 
 def test_kmer_counter():
@@ -85,3 +90,511 @@ def test_freq_spectrum():
         num_kmers = truth_spectrum[freq]
 
         assert spectrum[freq-1] == num_kmers
+
+
+def test_superkmer_counting():
+    counter = KmerCounter(5, 3, superkmers=True).count_kmers_files(['data/mccortex.fasta'])
+    counter_per_kmer = KmerCounter(5, 3, superkmers=False).count_kmers_files(['data/mccortex.fasta'])
+
+    assert dict(counter.items()) == dict(counter_per_kmer.items())
+    assert counter.num_kmers == counter_per_kmer.num_kmers
+    assert counter.num_unique == counter_per_kmer.num_unique
+    assert counter.max_count == counter_per_kmer.max_count
+
+
+# A max_memory of 1 byte splits each bucket into buckets of a single table
+@pytest.mark.parametrize("max_memory,num_buckets", [(1, 4), (1, 1), (2**30, 4)])
+def test_kmer_counter_external(tmp_path, max_memory, num_buckets):
+    counter = KmerCounter(5, 3, table_bits=4).count_kmers_files(['data/mccortex.fasta'])
+
+    file_path = str(tmp_path / "external.counts")
+    bucket_dir = tmp_path / "buckets"
+    bucket_dir.mkdir()
+
+    external = KmerCounter(5, 3, table_bits=4)
+    external.count_kmers_files_external(['data/mccortex.fasta'], file_path, tmp_dir=str(bucket_dir),
+                                        max_memory=max_memory, num_buckets=num_buckets)
+
+    # Temporary bucket files, including those of split buckets, are removed
+    assert list(bucket_dir.iterdir()) == []
+
+    assert external.num_kmers == counter.num_kmers
+    assert external.num_unique == counter.num_unique
+
+    counter_loaded = KmerCounter.from_file(file_path)
+    assert dict(counter_loaded.items()) == dict(counter.items())
+    assert counter_loaded.max_count == counter.max_count
+
+    with pytest.raises(RuntimeError, match="Could not open"):
+        KmerCounter(5, 3).count_kmers_files_external(['data/mccortex.fasta'], str(tmp_path / "missing" / "x.counts"),
+                                                     tmp_dir=str(bucket_dir))
+
+
+@pytest.mark.parametrize("counter_cls", [KmerCounter8, KmerCounter32])
+def test_kmer_counter_count_width(counter_cls):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 300
+
+    counter = KmerCounter(5, 3).count_kmers(test_str)
+    counter_width = counter_cls(5, 3).count_kmers(test_str)
+
+    assert dict(counter_width.items()) == dict(counter.items())
+    assert counter_width.query("AAAAA") == 296
+    assert counter_width.max_count == counter.max_count
+    assert list(counter_width.frequency_spectrum()) == list(counter.frequency_spectrum())
+
+
+@pytest.mark.parametrize("counter_cls", [KmerCounter, KmerCounter8, KmerCounter32])
+@pytest.mark.parametrize("superkmers", [True, False])
+def test_kmer_counter_concurrent(counter_cls, superkmers):
+    # Few distinct k-mers with high counts, so many threads update the same k-mers at once, and 8-bit counts move to
+    # the overflow table while other threads increment them
+    rng = random.Random(42)
+    repeat = "ACTGATTTCGATGCGATGCGATGCCACGGTGG"
+    reads = [repeat[rng.randrange(10):] + repeat + "".join(rng.choice("ACGT") for _ in range(rng.randrange(10)))
+             for _ in range(400)]
+
+    serial = counter_cls(5, 3, num_threads=1, superkmers=superkmers)
+    serial.start()
+    serial.feed(reads)
+    serial.finish()
+
+    concurrent = counter_cls(5, 3, num_threads=8, batch_size=4, superkmers=superkmers)
+    concurrent.start()
+    for i in range(0, len(reads), 20):
+        concurrent.feed(reads[i:i+20])
+
+    concurrent.finish()
+
+    assert max(count for _, count in serial.items()) > 255
+    assert dict(concurrent.items()) == dict(serial.items())
+    assert concurrent.num_kmers == serial.num_kmers
+    assert concurrent.max_count == serial.max_count
+    assert list(concurrent.frequency_spectrum()) == list(serial.frequency_spectrum())
+
+
+def test_kmer_counter_freeze(tmp_path):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 300
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    for counter_cls in (KmerCounter, KmerCounter8, KmerCounter32):
+        counter = counter_cls(5, 3).count_kmers(test_str)
+        frozen = counter.freeze()
+
+        assert len(frozen) == len(counter)
+        assert frozen.num_kmers == counter.num_kmers
+        assert frozen.max_count == counter.max_count
+
+        for kmer, truth in truth_counter.items():
+            assert frozen.query(kmer) == truth
+            assert frozen[kmer] == truth
+
+        file_path = str(tmp_path / "frozen.counts")
+        frozen.save(file_path)
+        frozen_loaded = type(frozen).from_file(file_path)
+
+        for kmer, truth in truth_counter.items():
+            assert frozen_loaded.query(kmer) == truth
+
+
+@pytest.mark.parametrize("counter_cls", [KmerCounter, KmerCounter8, KmerCounter32])
+def test_kmer_counter_load_count_width(tmp_path, counter_cls):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 300
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    counter = counter_cls(5, 3).count_kmers(test_str)
+    counter.save(str(tmp_path / "counter.counts"))
+    counter.save(str(tmp_path / "counter2.counts"))
+    counter.freeze().save(str(tmp_path / "frozen.counts"))
+
+    # The generic classes load the class with the count width of the file
+    loaded = KmerCounter.from_file(tmp_path / "counter.counts")
+    assert type(loaded).__name__ == counter_cls.__name__
+    assert dict(loaded.items()) == dict(truth_counter)
+
+    merged = KmerCounter.merge_files([tmp_path / "counter.counts", tmp_path / "counter2.counts"])
+    assert type(merged).__name__ == counter_cls.__name__
+    assert merged.num_kmers == 2 * counter.num_kmers
+
+    frozen = FrozenKmerCounter.from_file(tmp_path / "frozen.counts")
+    assert type(frozen).__name__ == "Frozen" + counter_cls.__name__
+    assert frozen.query(Kmer("AAAAA")) == truth_counter[Kmer("AAAAA")]
+
+    # Counter classes of another count width refuse the files
+    module = pyfrost.module_for_k(5)
+    for name in ("KmerCounter", "KmerCounter8", "KmerCounter32"):
+        if name != counter_cls.__name__:
+            with pytest.raises(RuntimeError, match="-bit counts"):
+                getattr(module, name).from_file(str(tmp_path / "counter.counts"))
+
+            with pytest.raises(RuntimeError, match="-bit counts"):
+                getattr(module, "Frozen" + name).from_file(str(tmp_path / "frozen.counts"))
+
+
+@pytest.mark.parametrize("counter_cls", [KmerCounter, KmerCounter8, KmerCounter32])
+def test_kmer_counter_save_sorted(tmp_path, counter_cls):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 300
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    counter = counter_cls(5, 3).count_kmers(test_str)
+    file_path = str(tmp_path / "sorted.counts")
+    counter.save_sorted(file_path)
+
+    mapped = MappedKmerCounter(file_path)
+    assert mapped.k == 5
+    assert len(mapped) == len(counter)
+    assert mapped.num_kmers == counter.num_kmers
+    assert mapped.max_count == counter.max_count
+
+    for kmer, truth in truth_counter.items():
+        assert mapped.query(kmer) == truth
+        assert mapped[kmer] == truth
+        assert mapped[kmer.twin()] == truth
+
+    assert mapped["CCCCC"] == 0
+
+    # Opening a file doesn't change the current k-mer size
+    pyfrost.set_k_g(7, 3)
+    with pytest.raises(RuntimeError, match="k-mer size"):
+        MappedKmerCounter(file_path)
+
+    pyfrost.set_k_g(5, 3)
+    with open(file_path, 'rb') as f:
+        data = f.read()
+
+    (tmp_path / "truncated.counts").write_bytes(data[:len(data) - 1])
+    with pytest.raises(RuntimeError, match="corrupt"):
+        MappedKmerCounter(str(tmp_path / "truncated.counts"))
+
+
+def test_kmer_counter_query_many():
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG"
+    counter = KmerCounter(5, 3, num_threads=4).count_kmers(test_str)
+
+    query_str = "ACTGATTTNGATGCCCCCC"
+    counts = counter.query_many(query_str)
+    assert counts.shape == (len(query_str) - 5 + 1,)
+
+    for i, count in enumerate(counts):
+        kmer_str = query_str[i:i+5]
+        assert count == (0 if "N" in kmer_str else counter.query(kmer_str))
+
+    kmers = [Kmer(test_str[i:i+5]) for i in range(len(test_str) - 5 + 1)]
+    assert numpy.array_equal(counter.query_many(kmers), [counter.query(kmer) for kmer in kmers])
+
+    assert len(counter.query_many("ACT")) == 0
+
+    with pytest.raises(ValueError):
+        counter.query_many(numpy.zeros(3, dtype=numpy.uint64))
+
+
+def test_kmer_counter_to_arrays():
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGGACTGATTTCG"
+    counter = KmerCounter(5, 3, num_threads=4).count_kmers(test_str)
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    kmers, counts = counter.to_arrays()
+    assert kmers.ndim == 2 and kmers.shape[0] == len(counts) == len(truth_counter)
+    assert kmers.dtype == numpy.uint64
+    assert numpy.array_equal(counter.query_many(kmers), counts)
+    assert counts.sum() == sum(truth_counter.values())
+
+    kmers, counts = counter.to_arrays(min_count=2, max_count=3)
+    assert len(counts) == sum(1 for c in truth_counter.values() if 2 <= c <= 3)
+    assert numpy.all((counts >= 2) & (counts <= 3))
+    assert numpy.array_equal(counter.query_many(kmers), counts)
+
+
+def test_build_from_counter():
+    counter = KmerCounter(5, 3).count_kmers_files(['data/mccortex.fasta'])
+
+    g = pyfrost.build_from_counter(counter, 1, g=3)
+    assert len(g) == 12
+    assert Kmer('ACTGA') in g
+    assert g.graph['color_names'] == ['counter']
+
+    g_named = pyfrost.build_from_counter(counter, 1, g=3, color_name="sample1")
+    assert g_named.graph['color_names'] == ['sample1']
+
+    for color_name in ("../sample1", "dir/sample1", "", ".."):
+        with pytest.raises(ValueError):
+            pyfrost.build_from_counter(counter, 1, g=3, color_name=color_name)
+
+    g_solid = pyfrost.build_from_counter(counter, 2, g=3)
+    num_solid = sum(1 for count in counter.values() if count >= 2)
+    assert sum(len(data['unitig_sequence']) - 5 + 1 for _, data in g_solid.nodes(data=True)) == num_solid
+
+    for node in g_solid.nodes:
+        assert counter[node] >= 2
+
+
+def test_kmer_counter_merge(tmp_path):
+    test_str1 = "ACTGATTTCGATGCGATGCGATGCCACGGTGG"
+    test_str2 = "GATGCGATGCCACGGTGGTTTTTTACGT"
+    truth_counter = Counter(Kmer(s[i:i+5]).rep() for s in (test_str1, test_str2) for i in range(len(s) - 5 + 1))
+
+    counter1 = KmerCounter(5, 3).count_kmers(test_str1)
+    counter2 = KmerCounter(5, 3).count_kmers(test_str2)
+    counter1.merge(counter2)
+
+    assert len(counter1) == len(truth_counter)
+    assert counter1.num_kmers == sum(truth_counter.values())
+    assert counter1.max_count == max(truth_counter.values())
+    for kmer, truth in truth_counter.items():
+        assert counter1[kmer] == truth
+
+    # Different number of tables
+    counter3 = KmerCounter(5, 3, table_bits=4).count_kmers(test_str1)
+    counter3.merge(KmerCounter(5, 3, table_bits=6).count_kmers(test_str2))
+    for kmer, truth in truth_counter.items():
+        assert counter3[kmer] == truth
+
+    file_paths = [str(tmp_path / f"counter{i}.counts") for i in range(3)]
+    for file_path, s in zip(file_paths, (test_str1, test_str2, test_str2)):
+        KmerCounter(5, 3).count_kmers(s).save(file_path)
+
+    merged = KmerCounter.merge_files(file_paths, num_threads=4)
+    truth_counter.update(Kmer(test_str2[i:i+5]).rep() for i in range(len(test_str2) - 5 + 1))
+
+    assert len(merged) == len(truth_counter)
+    assert merged.num_kmers == sum(truth_counter.values())
+    for kmer, truth in truth_counter.items():
+        assert merged[kmer] == truth
+
+    with pytest.raises(RuntimeError):
+        counter1.merge(KmerCounter(7, 3))
+
+
+@pytest.mark.parametrize("superkmers", [True, False])
+def test_kmer_counter_multiple_readers(superkmers):
+    files = ['data/mccortex.fasta', 'data/mccortex2.fasta', 'data/mccortex.fasta']
+    counter1 = KmerCounter(5, 3, superkmers=superkmers).count_kmers_files(files)
+    counter2 = KmerCounter(5, 3, num_threads=4, superkmers=superkmers, num_readers=3).count_kmers_files(files)
+
+    assert counter2.num_kmers == counter1.num_kmers
+    assert len(counter2) == len(counter1)
+    assert dict(counter2.items()) == dict(counter1.items())
+
+
+@pytest.mark.parametrize("superkmers", [True, False])
+def test_kmer_counter_singleton_filter(superkmers):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 20
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+    num_singletons = sum(1 for count in truth_counter.values() if count == 1)
+
+    counter = KmerCounter(5, 3, superkmers=superkmers, singleton_filter_bits=16).count_kmers(test_str)
+
+    assert counter.num_kmers == sum(truth_counter.values())
+    assert len(counter) == len(truth_counter) - num_singletons
+    assert counter.max_count == max(truth_counter.values())
+
+    for kmer, truth in truth_counter.items():
+        assert counter[kmer] == (0 if truth == 1 else truth)
+
+    assert counter.filtered_singletons == pytest.approx(num_singletons, abs=2)
+
+    spectrum = counter.frequency_spectrum()
+    assert spectrum[0] == counter.filtered_singletons
+    assert spectrum[1] == sum(1 for count in truth_counter.values() if count == 2)
+
+
+def test_kmer_counter_spectrum(tmp_path):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 20
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+    truth_spectrum = Counter(truth_counter.values())
+
+    counter = KmerCounter(5, 3, num_threads=4).count_kmers(test_str)
+    spectrum = counter.frequency_spectrum()
+    assert len(spectrum) == counter.max_count
+    assert list(spectrum) == [truth_spectrum[i + 1] for i in range(counter.max_count)]
+
+    all_counts = counter.all_counts()
+    assert len(all_counts) == len(counter)
+    assert sorted(all_counts) == sorted(truth_counter.values())
+
+    # The spectrum is recomputed when loading a counter
+    file_path = str(tmp_path / "spectrum.counts")
+    counter.save(file_path)
+    assert list(KmerCounter.from_file(file_path).frequency_spectrum()) == list(spectrum)
+
+
+@pytest.mark.parametrize("k,g", [(5, 3), (15, 7), (31, 23), (31, 30)])
+@pytest.mark.parametrize("canonical", [True, False])
+@pytest.mark.parametrize("superkmers", [True, False])
+def test_kmer_counter_partitions(k, g, canonical, superkmers):
+    rng = random.Random(k * g)
+    test_str = "".join(rng.choice("ACGT") for _ in range(3000))
+    kmers = [Kmer(test_str[i:i+k]) for i in range(len(test_str) - k + 1)]
+    truth_counter = Counter(kmer.rep() if canonical else kmer for kmer in kmers)
+
+    # Queries only look in the table the k-mer's minimizer assigns it to, with many tables any difference between the
+    # partition used while counting and the one used for queries shows up as missing k-mers
+    counter = KmerCounter(k, g, canonical=canonical, table_bits=8, superkmers=superkmers).count_kmers(test_str)
+    assert len(counter) == len(truth_counter)
+
+    for kmer, truth in truth_counter.items():
+        assert counter.query(kmer) == truth
+        if canonical:
+            assert counter.query(kmer.twin()) == truth
+
+    assert numpy.array_equal(counter.query_many(test_str), [truth_counter[kmer.rep() if canonical else kmer]
+                                                            for kmer in kmers])
+
+
+def write_baseline_counter(path, k, g, counts, num_tables=4):
+    """Write k-mer counts in the format of the original KmerCounter: a vector of robin_hood maps with 16-bit counts,
+    where each k-mer is stored as a length prefixed string of the bytes written by `Kmer::write`."""
+
+    kmer_words = (max_k + 1) // 32
+    tables = [[] for _ in range(num_tables)]
+    for i, (kmer, count) in enumerate(counts.items()):
+        tables[i % num_tables].append((str(kmer), count))
+
+    data = [struct.pack('<QQ?Q', k, g, True, num_tables)]
+    for table in tables:
+        data.append(struct.pack('<Q', len(table)))
+        for kmer, count in table:
+            # Base i is stored in word i / 32, starting from the most significant bits
+            words = [0] * kmer_words
+            for i, base in enumerate(kmer):
+                words[i // 32] |= "ACGT".index(base) << (62 - 2 * (i % 32))
+
+            data.append(struct.pack('<Q', 8 * kmer_words) + struct.pack(f'<{kmer_words}Q', *words))
+            data.append(struct.pack('<H', count))
+
+    data.append(struct.pack('<QQH', sum(counts.values()), len(counts), max(counts.values())))
+
+    with open(path, 'wb') as f:
+        f.write(b"".join(data))
+
+
+@pytest.fixture
+def baseline_counter_file(tmp_path):
+    # Counts above 255 check the conversion of the 16-bit counts for KmerCounter8
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" + "A" * 400
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    file_path = str(tmp_path / "baseline.counts")
+    write_baseline_counter(file_path, 5, 3, truth_counter)
+
+    return file_path, truth_counter
+
+
+@pytest.mark.parametrize("counter_cls", [KmerCounter, KmerCounter8, KmerCounter32])
+def test_kmer_counter_load_baseline(baseline_counter_file, counter_cls):
+    file_path, truth_counter = baseline_counter_file
+
+    loaded = counter_cls.from_file(file_path)
+    assert loaded.num_kmers == sum(truth_counter.values())
+    assert loaded.num_unique == len(truth_counter)
+    assert loaded.max_count == 396
+    assert dict(loaded.items()) == dict(truth_counter)
+
+    truth_spectrum = Counter(truth_counter.values())
+    assert list(loaded.frequency_spectrum()) == [truth_spectrum[i + 1] for i in range(loaded.max_count)]
+
+
+def rotate_counter_tables(src, dst, count_bytes):
+    """Rewrite a saved KmerCounter with the k-mers of each hash table moved to the next table, like a counter saved
+    with a different partitioning."""
+
+    kmer_bytes = 8 * ((max_k + 1) // 32)
+    with open(src, 'rb') as f:
+        data = f.read()
+
+    # k and g as uint64, canonical as bool, the count width tag and uint32 width, followed by the number of tables
+    tables_start = 8 + 8 + 1 + 8 + 4 + 8
+    num_tables, = struct.unpack_from('<Q', data, tables_start - 8)
+
+    tables = []
+    pos = tables_start
+    for _ in range(num_tables):
+        # K-mer format tag and version, the count width, the number of k-mers and the k-mers, and the vector of counts
+        num_kmers, = struct.unpack_from('<Q', data, pos + 16)
+        end = pos + 24 + num_kmers * kmer_bytes + 8 + num_kmers * count_bytes
+        tables.append(data[pos:end])
+        pos = end
+
+    with open(dst, 'wb') as f:
+        f.write(data[:tables_start] + b"".join(tables[-1:] + tables[:-1]) + data[pos:])
+
+
+# KmerCounter8 saves its counts with the 32-bit count type it reports to the user
+@pytest.mark.parametrize("counter_cls,count_bytes", [(KmerCounter, 2), (KmerCounter8, 4), (KmerCounter32, 4)])
+def test_kmer_counter_load_repartition(tmp_path, counter_cls, count_bytes):
+    rng = random.Random(42)
+    test_str = "".join(rng.choice("ACGT") for _ in range(2000))
+    truth_counter = Counter(Kmer(test_str[i:i+7]).rep() for i in range(len(test_str) - 7 + 1))
+
+    counter = counter_cls(7, 4, table_bits=4).count_kmers(test_str)
+    counter.save(str(tmp_path / "counter.bin"))
+
+    rotate_counter_tables(str(tmp_path / "counter.bin"), str(tmp_path / "rotated.bin"), count_bytes)
+
+    # Queries only look in the table of the k-mer's partition, so they only find the k-mers if loading repartitioned
+    # the tables
+    loaded = counter_cls.from_file(str(tmp_path / "rotated.bin"))
+    assert len(loaded) == len(truth_counter)
+    for kmer, truth in truth_counter.items():
+        assert loaded.query(kmer) == truth
+
+    assert list(loaded.frequency_spectrum()) == list(counter.frequency_spectrum())
+
+
+def test_kmer_counter_streaming():
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG"
+    reads = [test_str[i:i+12] for i in range(0, len(test_str) - 12 + 1, 3)]
+    truth_counter = Counter(Kmer(r[i:i+5]).rep() for r in reads for i in range(len(r) - 5 + 1))
+
+    counter = KmerCounter(5, 3, num_threads=3, batch_size=2)
+    counter.start()
+    assert counter.is_streaming
+
+    with pytest.raises(RuntimeError):
+        counter.start()
+
+    counter.feed(reads[:3])
+    counter.feed([r.encode('ascii') for r in reads[3:]])
+    counter.finish()
+    assert not counter.is_streaming
+
+    for kmer, truth in truth_counter.items():
+        assert counter.query(kmer) == truth
+
+    assert counter.num_kmers == sum(truth_counter.values())
+
+    with pytest.raises(RuntimeError):
+        counter.feed(reads)
+
+    with pytest.raises(RuntimeError):
+        counter.finish()
+
+
+def test_approx_kmer_counter(tmp_path):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG"
+    truth_counter = Counter(Kmer(test_str[i:i+5]).rep() for i in range(len(test_str) - 5 + 1))
+
+    counter = ApproxKmerCounter(5, 3, width_bits=12, depth=4, partition_bits=2).count_kmers(test_str)
+    assert counter.num_kmers == sum(truth_counter.values())
+    assert counter.memory_usage == 4 * 4 * 2**12
+    assert 0 < counter.delta < 0.02
+
+    for kmer, truth in truth_counter.items():
+        assert truth <= counter.query(kmer) <= truth + counter.error_bound(kmer)
+
+    counts = counter.query_many(test_str)
+    assert numpy.array_equal(counts, [counter.query(test_str[i:i+5]) for i in range(len(test_str) - 5 + 1)])
+
+    kmers, _ = KmerCounter(5, 3).count_kmers(test_str).to_arrays()
+    assert numpy.all(counter.query_many(kmers) >= 1)
+
+    counter.save(str(tmp_path / "approx.bin"))
+    loaded = ApproxKmerCounter.from_file(str(tmp_path / "approx.bin"))
+    for kmer in truth_counter:
+        assert loaded.query(kmer) == counter.query(kmer)
+
+    streamed = ApproxKmerCounter(5, 3, width_bits=12, partition_bits=2)
+    streamed.start()
+    streamed.feed([test_str])
+    streamed.finish()
+    for kmer in truth_counter:
+        assert streamed.query(kmer) == counter.query(kmer)
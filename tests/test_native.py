@@ -0,0 +1,142 @@
+import random
+
+import pytest  # noqa
+
+import pyfrostcpp
+
+import pyfrost
+from pyfrost import max_k, available_kmer_widths, module_for_k, KmerCounter, KmerCounter8
+from pyfrost._native import module_of
+
+extra_widths = sorted(available_kmer_widths())
+
+
+def test_module_for_k():
+    assert module_for_k(5) is pyfrostcpp
+    assert module_for_k(max_k) is pyfrostcpp
+
+    widths = [max_k + 1] + extra_widths
+    for smaller, width in zip(widths, widths[1:]):
+        # Narrowest module that fits
+        assert module_for_k(smaller).__name__ == f"pyfrostcpp_k{width}"
+        assert module_for_k(width - 1).__name__ == f"pyfrostcpp_k{width}"
+
+    with pytest.raises(ValueError):
+        module_for_k(widths[-1])
+
+    module_for_k(5)
+
+
+def test_set_k_g_dispatch():
+    pyfrost.set_k_g(5, 3)
+    assert pyfrost.k_g() == (5, 3)
+    assert pyfrostcpp.k_g() == (5, 3)
+
+    for width in extra_widths:
+        pyfrost.set_k_g(width - 1)
+        assert pyfrost.k() == width - 1
+
+        # The default module keeps its k-mer size
+        assert pyfrostcpp.k() == 5
+
+    pyfrost.set_k_g(5, 3)
+
+
+def test_kmer_counter_dispatch(tmp_path):
+    test_str = "ACTGATTTCGATGCGATGCGATGCCACGGTGG" * 4
+
+    counter = KmerCounter(5, 3).count_kmers(test_str)
+    assert module_of(counter) is pyfrostcpp
+    assert isinstance(counter, KmerCounter)
+    assert not isinstance(counter, KmerCounter8)
+
+    first_count = counter[test_str[:5]]
+    counter.save(str(tmp_path / "k5.counts"))
+    assert module_of(KmerCounter.from_file(tmp_path / "k5.counts")) is pyfrostcpp
+
+    for width in extra_widths:
+        k = width - 1
+        wide = KmerCounter(k).count_kmers(test_str)
+
+        assert module_of(wide).__name__ == f"pyfrostcpp_k{width}"
+        assert isinstance(wide, KmerCounter)
+        assert wide.num_kmers == len(test_str) - k + 1
+
+        # Counters of different widths can be used side by side
+        assert counter[test_str[:5]] == first_count
+
+        wide.save(str(tmp_path / f"k{k}.counts"))
+        loaded = KmerCounter.from_file(tmp_path / f"k{k}.counts")
+        assert module_of(loaded) is module_of(wide)
+        assert loaded[test_str[:k]] == wide[test_str[:k]]
+
+    pyfrost.set_k_g(5, 3)
+
+
+def test_sequence_dispatch():
+    pyfrost.set_k_g(5, 3)
+
+    kmer = pyfrost.Kmer("ACGTA")
+    assert module_of(kmer) is pyfrostcpp
+    assert isinstance(kmer, pyfrost.Kmer)
+    assert isinstance(pyfrostcpp.Kmer("ACGTA"), pyfrost.Kmer)
+    assert not isinstance("ACGTA", pyfrost.Kmer)
+
+    for width in extra_widths:
+        k = width - 1
+        pyfrost.set_k_g(k)
+        seq = "ACGTTGCAATC" * (k // 11 + 2)
+
+        # K-mers and minimizers come from the module of the current k-mer size
+        kmer = pyfrost.Kmer(seq[:k])
+        native = module_of(kmer)
+        assert native.__name__ == f"pyfrostcpp_k{width}"
+        assert isinstance(kmer, pyfrost.Kmer)
+        assert str(kmer) == seq[:k]
+
+        assert module_of(pyfrost.KmerArray.from_strings([seq[:k]])) is native
+        assert [str(km) for km in pyfrost.kmerize_str(seq)] == [seq[i:i+k] for i in range(len(seq) - k + 1)]
+
+        kmers, _, _ = pyfrost.kmerize_batch([seq])
+        assert module_of(kmers) is native
+        assert len(kmers) == len(seq) - k + 1
+
+        assert len(pyfrost.minimizers_array(seq).hashes) > 0
+        assert all(module_of(result.minimizer) is native for result in pyfrost.all_minimizers(seq))
+
+        # The default module keeps its k-mer size
+        assert len(pyfrostcpp.Kmer("ACGTA")) == 5
+
+    pyfrost.set_k_g(5, 3)
+
+
+@pytest.mark.skipif(not extra_widths, reason="no additional k-mer width modules installed")
+def test_build_dispatch(tmp_path):
+    width = extra_widths[0]
+    k = width - 1
+
+    rng = random.Random(42)
+    fasta = tmp_path / "random.fasta"
+    fasta.write_text(">seq\n" + "".join(rng.choice("ACGT") for _ in range(500)) + "\n")
+
+    g = pyfrost.build_from_refs(['data/mccortex.fasta'], k=5, g=3)
+    wide = pyfrost.build_from_refs([str(fasta)], k=k)
+
+    assert module_of(g._ccdbg) is pyfrostcpp
+    assert module_of(wide._ccdbg).__name__ == f"pyfrostcpp_k{width}"
+    assert wide.graph['k'] == k
+    assert len(g.nodes) == 12
+
+    # Nodes given as strings are converted to k-mers of the graph's width
+    head = next(iter(wide.nodes))
+    assert isinstance(head, wide._kmer_type)
+    assert list(wide.color_restricted_successors(str(head), 0)) == list(wide.successors(head))
+
+    # A k-mer of the graph's width is a single source node
+    assert head in pyfrost.get_neighborhood(wide, head, radius=0)
+
+    wide_snapshot = tmp_path / "wide.snap"
+    pyfrost.dump_snapshot(wide, wide_snapshot)
+    assert module_of(pyfrost.load_snapshot(wide_snapshot)) is module_of(wide._ccdbg)
+
+    pyfrost.set_k_g(5, 3)
@@ -1,7 +1,11 @@
 import pickle
+import random
+import numpy
 import pytest  # noqa
 
-from pyfrost import Kmer, path_sequence, path_nucleotide_length, path_kmers, kmerize_str, set_k
+from pyfrost import (Kmer, KmerArray, path_sequence, path_nucleotide_length, path_kmers, kmerize_str, kmerize_batch,
+                     set_k, set_k_g, minimizers_array, minimizers_batch, Strand)
+from pyfrostcpp import BaseEncoder, set_base_encoder, minhash_iter
 
 
 def test_kmer_pickle(mccortex, tmp_path):
@@ -49,6 +53,121 @@ def test_kmerize_str():
     ]
 
 
+def test_kmer_array():
+    set_k(5)
+
+    seq = "ACTGATTTCGATGCNACTGA"
+    kmers = kmerize_str(seq).to_array()
+    assert len(kmers) == 11
+    assert list(kmers) == list(kmerize_str(seq))
+    assert kmers[-1] == Kmer('ACTGA')
+
+    assert kmers.to_strings() == [str(k) for k in kmerize_str(seq)]
+    assert list(kmers.twin()) == [k.twin() for k in kmerize_str(seq)]
+    assert list(kmers.rep()) == [k.rep() for k in kmerize_str(seq)]
+    assert list(kmerize_str(seq).to_array(canonical=True)) == [k.rep() for k in kmerize_str(seq)]
+    assert kmers.hash(seed=3).tolist() == [k.hash(3) for k in kmerize_str(seq)]
+
+    strings = ['TCGAT', 'ACTGA', 'TCGAT', 'GGGGG']
+    other = KmerArray.from_strings(strings)
+    assert list(KmerArray.from_strings(strings).sort()) == sorted(Kmer(s) for s in strings)
+    assert list(other.unique()) == sorted({Kmer(s) for s in strings})
+    assert kmers.isin(other).tolist() == [str(k) in strings for k in kmerize_str(seq)]
+
+    # Buffer protocol round trip
+    words = numpy.asarray(kmers)
+    assert words.shape[0] == len(kmers)
+    assert list(KmerArray(words)) == list(kmers)
+
+    with pytest.raises(ValueError):
+        KmerArray.from_strings(['ACT'])
+
+
+def test_kmerize_batch():
+    set_k(5)
+
+    seqs = ["ACTGATTTCGATGC", "ACT", "GGNNACGTTAC", "ACTGA"]
+    for threads in (1, 3):
+        kmers, seq_ix, positions = kmerize_batch(seqs, canonical=True, threads=threads)
+
+        expected = [(i, pos, Kmer(s[pos:pos+5]).rep()) for i, s in enumerate(seqs)
+                    for pos in range(len(s) - 4) if 'N' not in s[pos:pos+5]]
+        assert list(zip(seq_ix.tolist(), positions.tolist(), kmers)) == expected
+
+
+def test_minimizers_array():
+    seq = "ACTGATTTCGATGCTTAGNNACGTAGCTAGCAATCG"
+    mins = minimizers_array(seq, 7, 3)
+
+    # Super-k-mers together cover all k-mers without N, in order
+    kmer_positions = [p for s, e in zip(mins.starts.tolist(), mins.ends.tolist()) for p in range(s, e - 6)]
+    assert kmer_positions == [p for p in range(len(seq) - 6) if 'N' not in seq[p:p+7]]
+
+    for pos, strand, start, end in zip(mins.positions, mins.strands, mins.starts, mins.ends):
+        assert start <= pos and pos + 3 <= start + 7
+
+        gmer = seq[pos:pos+3]
+        rc = gmer[::-1].translate(str.maketrans("ACGT", "TGCA"))
+        assert (strand == int(Strand.FORWARD)) == (gmer <= rc)
+
+    # Same minimizers as `minhash_iter`, the leftmost one if several g-mers have the smallest hash
+    plain_seq = seq[:seq.index('N')]
+    plain_mins = minimizers_array(plain_seq, 7, 3)
+    minhash_results = [[(r.hash, r.pos) for r in results] for results in minhash_iter(plain_seq, 7, 3)]
+
+    kmer_pos = 0
+    for h, pos, start, end in zip(plain_mins.hashes.tolist(), plain_mins.positions.tolist(),
+                                  plain_mins.starts.tolist(), plain_mins.ends.tolist()):
+        for kmer_pos in range(start, end - 6):
+            assert {r_hash for r_hash, _ in minhash_results[kmer_pos]} == {h}
+            assert pos == min(r_pos for _, r_pos in minhash_results[kmer_pos])
+
+    assert kmer_pos == len(plain_seq) - 7
+
+    batch = minimizers_batch([seq, "ACG", seq], threads=2)
+    n = len(mins.hashes)
+    assert batch.seq_indices.tolist() == [0] * n + [2] * n
+    assert batch.hashes.tolist() == mins.hashes.tolist() * 2
+    assert batch.starts.tolist() == mins.starts.tolist() * 2
+
+
+@pytest.mark.parametrize("k,g", [(5, 3), (31, 23)])
+def test_base_encoders(k, g):
+    set_k_g(k, g)
+    rng = random.Random(42)
+
+    # Lengths around the 32 base vector width, with lowercase bases and N's or other characters breaking up k-mers
+    seqs = []
+    for length in [k - 1, k, 31, 32, 33, 63, 64, 65, 100, 257]:
+        for _ in range(5):
+            alphabet = "ACGTacgt" * 8 + "NnR-"
+            seqs.append("".join(rng.choice(alphabet) for _ in range(length)))
+
+    def extract():
+        kmers, seq_ix, positions = kmerize_batch(seqs, canonical=False, threads=2)
+        rep_kmers, _, _ = kmerize_batch(seqs, canonical=True, threads=2)
+        mins = minimizers_batch(seqs, threads=2)
+
+        return ([str(kmer) for kmer in kmers], [str(kmer) for kmer in rep_kmers], seq_ix.tolist(), positions.tolist(),
+                [arr.tolist() for arr in mins])
+
+    try:
+        assert set_base_encoder(BaseEncoder.SCALAR)
+        scalar = extract()
+
+        if not set_base_encoder(BaseEncoder.AVX2):
+            pytest.skip("CPU doesn't support AVX2")
+
+        assert extract() == scalar
+    finally:
+        set_base_encoder(BaseEncoder.AUTO)
+
+    kmers, _, _, positions, _ = scalar
+    expected = [(pos, s[pos:pos+k].upper()) for s in seqs for pos in range(len(s) - k + 1)
+                if set(s[pos:pos+k].upper()) <= set("ACGT")]
+    assert list(zip(positions, kmers)) == expected
+
+
 def test_kmerize_path(mccortex):
     set_k(5)
     g = mccortex
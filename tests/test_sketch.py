@@ -0,0 +1,74 @@
+import numpy
+import pytest  # noqa
+
+from pyfrost import (FracMinHash, set_k, kmerize_str, sketch_files, sketch_colors, jaccard_matrix, containment_matrix,
+                     save_sketches, load_sketches)
+
+
+def test_fracminhash():
+    set_k(5)
+
+    seq = "ACTGATTTCGATGCGATGCGATGCCACGTTAGCA"
+    full = FracMinHash(scale=1, name="full")
+    full.add_sequence(seq)
+
+    # With scale 1, all distinct canonical k-mers are kept
+    assert len(full) == len({k.rep() for k in kmerize_str(seq)})
+    assert full.name == "full"
+    assert full.jaccard(full) == 1.0
+
+    half = FracMinHash(scale=1)
+    half.add_sequence(seq[:len(seq) // 2])
+    assert half.containment(full) == 1.0
+    assert 0 < full.containment(half) < 1.0
+    assert full.jaccard(half) == pytest.approx(len(half) / len(full))
+
+    with pytest.raises(RuntimeError):
+        full.jaccard(FracMinHash(scale=10))
+
+    # Hashes are sorted and deduplicated lazily, before comparisons
+    repeated = FracMinHash(scale=1)
+    for _ in range(3):
+        repeated.add_sequence(seq)
+        repeated.add_sequence(seq[:len(seq) // 2])
+
+    matrix = jaccard_matrix([repeated, full, repeated])
+    assert numpy.allclose(matrix, 1.0)
+    assert len(repeated) == len(full)
+    assert repeated.hashes.tolist() == sorted(full.hashes.tolist())
+
+    repeated.add_sequence(seq)
+    assert repeated.jaccard(full) == 1.0
+
+    # Merging a sketch with itself keeps the same hashes
+    repeated.add_sequence(seq)
+    repeated.merge(repeated)
+    assert repeated.hashes.tolist() == full.hashes.tolist()
+
+
+def test_sketch_files(mccortex, tmp_path):
+    set_k(5)
+
+    sketches = sketch_files(['data/mccortex.fasta', 'data/mccortex2.fasta'], scale=1, threads=2)
+    assert [s.name for s in sketches] == ['data/mccortex.fasta', 'data/mccortex2.fasta']
+
+    jaccard = jaccard_matrix(sketches)
+    assert jaccard.shape == (2, 2)
+    assert numpy.allclose(numpy.diag(jaccard), 1.0)
+    assert jaccard[0, 1] == jaccard[1, 0]
+
+    containment = containment_matrix(sketches[:1], sketches)
+    assert containment.shape == (1, 2)
+    assert containment[0, 0] == 1.0
+
+    # The graph has the k-mers of a single file, so its only color has the same sketch
+    colors = sketch_colors(mccortex, scale=1)
+    assert len(colors) == 1
+    assert colors[0].hashes.tolist() == sketches[0].hashes.tolist()
+
+    save_sketches(sketches, str(tmp_path / "sketches.bin"))
+    loaded = load_sketches(str(tmp_path / "sketches.bin"))
+    assert [s.hashes.tolist() for s in loaded] == [s.hashes.tolist() for s in sketches]
+
+    with pytest.raises(RuntimeError):
+        save_sketches(sketches, str(tmp_path / "missing" / "sketches.bin"))